@@ -0,0 +1,150 @@
+#ifndef OSMIUM_AREA_ASSEMBLE_WAYS_HPP
+#define OSMIUM_AREA_ASSEMBLE_WAYS_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <future>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * Closed ways with more than three nodes can be areas on their own
+         * if they are not in a multipolygon relation.
+         */
+        inline bool way_can_be_area(const osmium::Way& way) {
+            return way.ends_have_same_location() && way.nodes().size() > 3;
+        }
+
+        namespace detail {
+
+            template <class TAssembler>
+            void assemble_ways(TAssembler& assembler, osmium::memory::Buffer::t_const_iterator<osmium::Way> begin, osmium::memory::Buffer::t_const_iterator<osmium::Way> end, osmium::memory::Buffer& out_buffer) {
+                for (auto it = begin; it != end; ++it) {
+                    if (way_can_be_area(*it)) {
+                        try {
+                            assembler(*it, out_buffer);
+                        } catch (osmium::invalid_location&) {
+                            // XXX ignore
+                        }
+                    }
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Assemble areas from all closed ways in the input buffer (see
+         * way_can_be_area()) using the given assembler for all of them.
+         * Other objects in the buffer are ignored. The areas are appended
+         * to the output buffer.
+         */
+        template <class TAssembler>
+        void assemble_closed_ways(TAssembler& assembler, const osmium::memory::Buffer& in_buffer, osmium::memory::Buffer& out_buffer) {
+            detail::assemble_ways(assembler, in_buffer.cbegin<osmium::Way>(), in_buffer.cend<osmium::Way>(), out_buffer);
+        }
+
+        /**
+         * Assemble areas from all closed ways in the input buffer like
+         * assemble_closed_ways(), but in the thread pool. The buffer is
+         * split into one chunk per pool thread and each chunk is
+         * assembled by its own TAssembler. The areas are appended to the
+         * output buffer in the same order as the ways in the input.
+         *
+         * Because problem reporters are not thread safe, everything runs
+         * in the calling thread if a problem reporter or debug output is
+         * configured. Don't call this from inside a pool task.
+         */
+        template <class TAssembler>
+        void assemble_closed_ways_parallel(const typename TAssembler::config_type& config, const osmium::memory::Buffer& in_buffer, osmium::memory::Buffer& out_buffer) {
+            const size_t num_chunks = static_cast<size_t>(osmium::thread::Pool::instance().num_threads());
+            if (config.problem_reporter || config.debug || num_chunks < 2) {
+                TAssembler assembler(config);
+                assemble_closed_ways(assembler, in_buffer, out_buffer);
+                return;
+            }
+
+            // split the buffer into chunks of about the same size at item boundaries
+            const unsigned char* const data = in_buffer.data();
+            const unsigned char* const end = data + in_buffer.committed();
+            const size_t chunk_size = in_buffer.committed() / num_chunks + 1;
+            std::vector<const unsigned char*> bounds {data};
+            for (auto it = in_buffer.cbegin(); it != in_buffer.cend(); ++it) {
+                const unsigned char* item = reinterpret_cast<const unsigned char*>(&*it);
+                if (static_cast<size_t>(item - bounds.back()) >= chunk_size) {
+                    bounds.push_back(item);
+                }
+            }
+            bounds.push_back(end);
+
+            std::vector<std::future<osmium::memory::Buffer>> results;
+            results.reserve(bounds.size() - 1);
+            for (size_t n = 0; n + 1 < bounds.size(); ++n) {
+                const unsigned char* chunk_begin = bounds[n];
+                const unsigned char* chunk_end = bounds[n + 1];
+                results.push_back(osmium::thread::Pool::instance().submit([&config, chunk_begin, chunk_end] {
+                    osmium::memory::Buffer output(static_cast<size_t>(chunk_end - chunk_begin) + 1024 * 8, osmium::memory::Buffer::auto_grow::yes);
+                    TAssembler assembler(config);
+                    detail::assemble_ways(assembler,
+                                          osmium::memory::Buffer::t_const_iterator<osmium::Way>(chunk_begin, chunk_end),
+                                          osmium::memory::Buffer::t_const_iterator<osmium::Way>(chunk_end, chunk_end),
+                                          output);
+                    return output;
+                }));
+            }
+
+            // wait for all tasks before the first get() might throw, they
+            // use the input buffer
+            for (auto& result : results) {
+                result.wait();
+            }
+            for (auto& result : results) {
+                osmium::memory::Buffer output = result.get();
+                out_buffer.add_buffer(output);
+                out_buffer.commit();
+            }
+        }
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_ASSEMBLE_WAYS_HPP
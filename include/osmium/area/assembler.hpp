@@ -34,13 +34,19 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <list>
 #include <map>
+#include <set>
+#include <utility>
 #include <vector>
 
 #include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/memory/arena.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/area.hpp>
 #include <osmium/osm/location.hpp>
@@ -86,6 +92,10 @@ namespace osmium {
          * Assembles area objects from multipolygon relations and their
          * members. This is called by the MultipolygonCollector object
          * after all members have been collected.
+         *
+         * An Assembler can be used for any number of ways and relations
+         * one after the other. Reusing it is cheaper than creating a new
+         * one each time.
          */
         class Assembler {
 
@@ -94,14 +104,36 @@ namespace osmium {
             // The way segments
             osmium::area::detail::SegmentList m_segment_list;
 
+            // Memory for the temporary data structures below. It is
+            // reset at the start of each call, so an Assembler reused for
+            // many objects doesn't allocate after the first few.
+            osmium::memory::Arena m_arena;
+
+            typedef std::list<ProtoRing, osmium::memory::ArenaAllocator<ProtoRing>> ring_list_type;
+            typedef std::vector<ProtoRing*, osmium::memory::ArenaAllocator<ProtoRing*>> ring_ptr_vector_type;
+
             // The rings we are building from the way segments
-            std::list<ProtoRing> m_rings {};
+            ring_list_type m_rings;
+
+            ring_ptr_vector_type m_outer_rings;
+            ring_ptr_vector_type m_inner_rings;
 
-            std::vector<ProtoRing*> m_outer_rings {};
-            std::vector<ProtoRing*> m_inner_rings {};
+            // The ring each segment in m_segment_list ended up in
+            std::vector<const ProtoRing*, osmium::memory::ArenaAllocator<const ProtoRing*>> m_segment_rings;
+
+            // The ways (and their roles) the area is built from, used
+            // by the fast path in create_rings()
+            std::vector<std::pair<const osmium::Way*, const char*>, osmium::memory::ArenaAllocator<std::pair<const osmium::Way*, const char*>>> m_ways;
 
             int m_inner_outer_mismatches { 0 };
 
+            // Tags ignored when deciding whether a relation has tags
+            osmium::tags::KeyFilter m_relation_tags_filter;
+
+            // Tags ignored when comparing the tags of inner ways with
+            // those of the area
+            osmium::tags::KeyFilter m_inner_way_tags_filter;
+
             bool debug() const {
                 return m_config.debug;
             }
@@ -131,36 +163,39 @@ namespace osmium {
                 }
             }
 
-            void add_common_tags(osmium::builder::TagListBuilder& tl_builder, std::set<const osmium::Way*>& ways) const {
-                std::map<std::string, size_t> counter;
+            typedef std::set<const osmium::Way*, std::less<const osmium::Way*>, osmium::memory::ArenaAllocator<const osmium::Way*>> way_set_type;
+
+            // Orders tags by key and then by value.
+            struct tag_less {
+                bool operator()(const std::pair<const char*, const char*>& lhs, const std::pair<const char*, const char*>& rhs) const {
+                    const int c = std::strcmp(lhs.first, rhs.first);
+                    return c < 0 || (c == 0 && std::strcmp(lhs.second, rhs.second) < 0);
+                }
+            }; // struct tag_less
+
+            void add_common_tags(osmium::builder::TagListBuilder& tl_builder, const way_set_type& ways) {
+                typedef std::pair<const char*, const char*> tag_type;
+                std::map<tag_type, size_t, tag_less, osmium::memory::ArenaAllocator<std::pair<const tag_type, size_t>>> counter(tag_less(), m_arena);
                 for (const osmium::Way* way : ways) {
                     for (const auto& tag : way->tags()) {
-                        std::string kv {tag.key()};
-                        kv.append(1, '\0');
-                        kv.append(tag.value());
-                        ++counter[kv];
+                        ++counter[tag_type(tag.key(), tag.value())];
                     }
                 }
 
                 size_t num_ways = ways.size();
                 for (const auto& t_c : counter) {
                     if (debug()) {
-                        std::cerr << "        tag " << t_c.first << " is used " << t_c.second << " times in " << num_ways << " ways\n";
+                        std::cerr << "        tag " << t_c.first.first << "=" << t_c.first.second << " is used " << t_c.second << " times in " << num_ways << " ways\n";
                     }
                     if (t_c.second == num_ways) {
-                        size_t len = std::strlen(t_c.first.c_str());
-                        tl_builder.add_tag(t_c.first.c_str(), t_c.first.c_str() + len + 1);
+                        tl_builder.add_tag(t_c.first.first, t_c.first.second);
                     }
                 }
             }
 
-            void add_tags_to_area(osmium::builder::AreaBuilder& builder, const osmium::Relation& relation) const {
-                osmium::tags::KeyFilter filter(true);
-                filter.add(false, "type").add(false, "created_by").add(false, "source").add(false, "note");
-                filter.add(false, "test:id").add(false, "test:section");
-
-                osmium::tags::KeyFilter::iterator fi_begin(filter, relation.tags().begin(), relation.tags().end());
-                osmium::tags::KeyFilter::iterator fi_end(filter, relation.tags().end(), relation.tags().end());
+            void add_tags_to_area(osmium::builder::AreaBuilder& builder, const osmium::Relation& relation) {
+                osmium::tags::KeyFilter::iterator fi_begin(m_relation_tags_filter, relation.tags().begin(), relation.tags().end());
+                osmium::tags::KeyFilter::iterator fi_end(m_relation_tags_filter, relation.tags().end(), relation.tags().end());
 
                 size_t count = std::distance(fi_begin, fi_end);
 
@@ -184,7 +219,7 @@ namespace osmium {
                     if (debug()) {
                         std::cerr << "    use tags from outer ways\n";
                     }
-                    std::set<const osmium::Way*> ways;
+                    way_set_type ways(std::less<const osmium::Way*>(), m_arena);
                     for (const auto& ring : m_outer_rings) {
                         ring->get_ways(ways);
                     }
@@ -474,6 +509,31 @@ namespace osmium {
                 return false;
             }
 
+            /**
+             * Remember for each segment in the segment list which ring it
+             * is in.
+             */
+            void find_segment_rings() {
+                m_segment_rings.assign(m_segment_list.size(), nullptr);
+                for (const auto& ring : m_rings) {
+                    for (osmium::area::detail::NodeRefSegment segment : ring.segments()) {
+                        if (segment.second().location() < segment.first().location()) {
+                            segment.swap_locations();
+                        }
+                        const auto it = std::lower_bound(m_segment_list.begin(), m_segment_list.end(), segment);
+                        assert(it != m_segment_list.end() && *it == segment);
+                        m_segment_rings[static_cast<size_t>(it - m_segment_list.begin())] = &ring;
+                    }
+                }
+            }
+
+            /**
+             * Find out whether the ring is an inner ring by counting the
+             * segments of other rings to the left of its leftmost node.
+             * Needs find_segment_rings() and SegmentList::build_y_index()
+             * to have been called, so that only the segments crossing
+             * the y coordinate of that node are looked at.
+             */
             void check_inner_outer(ProtoRing& ring) {
                 const osmium::NodeRef& min_node = ring.min_node();
                 if (debug()) {
@@ -483,33 +543,35 @@ namespace osmium {
                 int count = 0;
                 int above = 0;
 
-                for (auto it = m_segment_list.begin(); it != m_segment_list.end() && it->first().location().x() <= min_node.location().x(); ++it) {
-                    if (!ring.contains(*it)) {
+                m_segment_list.for_each_segment_at(min_node.location(), [&](size_t n) {
+                    if (m_segment_rings[n] == &ring) {
+                        return;
+                    }
+                    const osmium::area::detail::NodeRefSegment& segment = m_segment_list[n];
+                    if (debug()) {
+                        std::cerr << "      segments for count: " << segment;
+                    }
+                    if (segment.to_left_of(min_node.location())) {
+                        ++count;
                         if (debug()) {
-                            std::cerr << "      segments for count: " << *it;
+                            std::cerr << " counted\n";
                         }
-                        if (it->to_left_of(min_node.location())) {
-                            ++count;
-                            if (debug()) {
-                                std::cerr << " counted\n";
-                            }
-                        } else {
-                            if (debug()) {
-                                std::cerr << " not counted\n";
-                            }
+                    } else {
+                        if (debug()) {
+                            std::cerr << " not counted\n";
                         }
-                        if (it->first().location() == min_node.location()) {
-                            if (it->second().location().y() > min_node.location().y()) {
-                                ++above;
-                            }
+                    }
+                    if (segment.first().location() == min_node.location()) {
+                        if (segment.second().location().y() > min_node.location().y()) {
+                            ++above;
                         }
-                        if (it->second().location() == min_node.location()) {
-                            if (it->first().location().y() > min_node.location().y()) {
-                                ++above;
-                            }
+                    }
+                    if (segment.second().location() == min_node.location()) {
+                        if (segment.first().location().y() > min_node.location().y()) {
+                            ++above;
                         }
                     }
-                }
+                });
 
                 if (debug()) {
                     std::cerr << "      count=" << count << " above=" << above << "\n";
@@ -556,23 +618,28 @@ namespace osmium {
             }
 
             /**
-             * Create rings from segments.
+             * Forget everything about the last object assembled and give
+             * the temporary memory back to the arena.
              */
-            bool create_rings() {
-                m_segment_list.sort();
-                m_segment_list.erase_duplicate_segments();
-
-                // Now we look for segments crossing each other. If there are
-                // any, the multipolygon is invalid.
-                // In the future this could be improved by trying to fix those
-                // cases.
-                if (m_segment_list.find_intersections(m_config.problem_reporter)) {
-                    return false;
-                }
+            void reset() {
+                m_segment_list.clear();
+                m_rings.clear();
+                ring_ptr_vector_type(m_arena).swap(m_outer_rings);
+                ring_ptr_vector_type(m_arena).swap(m_inner_rings);
+                decltype(m_segment_rings)(m_arena).swap(m_segment_rings);
+                decltype(m_ways)(m_arena).swap(m_ways);
+                m_inner_outer_mismatches = 0;
+                m_arena.reset();
+            }
 
-                // Now iterator over all segments and add them to rings. Each segment
-                // is tacked on to either end of an existing ring if possible, or a
-                // new ring is started with it.
+            /**
+             * Put the segments together into rings. Each segment is tacked
+             * on to either end of an existing ring if possible, or a new
+             * ring is started with it.
+             *
+             * @returns false if not all rings could be closed
+             */
+            bool create_rings_from_segments() {
                 for (const auto& segment : m_segment_list) {
                     if (debug()) {
                         std::cerr << "  checking segment " << segment << "\n";
@@ -603,6 +670,70 @@ namespace osmium {
                     return false;
                 }
 
+                return true;
+            }
+
+            /**
+             * Check whether each of the ways is a closed ring on its own
+             * and no location is used more than once in all of them. This
+             * is the case for most areas. The ways are the rings then and
+             * don't have to be put together from the segments.
+             */
+            bool ways_are_simple_rings() {
+                if (m_ways.empty()) {
+                    return false;
+                }
+
+                std::vector<osmium::Location, osmium::memory::ArenaAllocator<osmium::Location>> locations(m_arena);
+                locations.reserve(m_segment_list.size());
+                for (const auto& way_role : m_ways) {
+                    const osmium::WayNodeList& nodes = way_role.first->nodes();
+                    if (nodes.size() < 4 || !way_role.first->ends_have_same_id() || nodes.front().location() != nodes.back().location()) {
+                        return false;
+                    }
+                    for (size_t i = 0; i < nodes.size() - 1; ++i) {
+                        if (!nodes[i].location().valid()) {
+                            return false;
+                        }
+                        locations.push_back(nodes[i].location());
+                    }
+                }
+
+                std::sort(locations.begin(), locations.end());
+                return std::adjacent_find(locations.begin(), locations.end()) == locations.end();
+            }
+
+            /**
+             * Create rings from the ways or, if they are not simple rings
+             * already, from their segments.
+             */
+            bool create_rings() {
+                const bool simple_rings = ways_are_simple_rings();
+
+                m_segment_list.sort();
+                if (!simple_rings) {
+                    m_segment_list.erase_duplicate_segments();
+                }
+
+                // Now we look for segments crossing each other. If there are
+                // any, the multipolygon is invalid.
+                // In the future this could be improved by trying to fix those
+                // cases.
+                if (m_segment_list.find_intersections(m_config.problem_reporter)) {
+                    return false;
+                }
+
+                if (simple_rings) {
+                    if (debug()) {
+                        std::cerr << "  all ways are closed rings, using them as they are\n";
+                    }
+                    for (const auto& way_role : m_ways) {
+                        m_rings.emplace_back(*way_role.first, way_role.second);
+                    }
+                } else if (!create_rings_from_segments()) {
+                    return false;
+                }
+
                 if (debug()) {
                     std::cerr << "  Find inner/outer...\n";
                 }
@@ -610,6 +741,8 @@ namespace osmium {
                 if (m_rings.size() == 1) {
                     m_outer_rings.push_back(&m_rings.front());
                 } else {
+                    find_segment_rings();
+                    m_segment_list.build_y_index();
                     for (auto& ring : m_rings) {
                         check_inner_outer(ring);
                         if (ring.outer()) {
@@ -630,6 +763,9 @@ namespace osmium {
                             m_outer_rings.front()->add_inner_ring(inner);
                         }
                     } else {
+                        for (auto outer : m_outer_rings) {
+                            outer->update_bounding_box();
+                        }
                         // sort outer rings by size, smallest first
                         std::sort(m_outer_rings.begin(), m_outer_rings.end(), [](ProtoRing* a, ProtoRing* b) {
                             return a->area() < b->area();
@@ -656,7 +792,19 @@ namespace osmium {
 
             explicit Assembler(const config_type& config) :
                 m_config(config),
-                m_segment_list(config.debug) {
+                m_segment_list(config.debug),
+                m_arena(),
+                m_rings(m_arena),
+                m_outer_rings(m_arena),
+                m_inner_rings(m_arena),
+                m_segment_rings(m_arena),
+                m_ways(m_arena),
+                m_relation_tags_filter(true),
+                m_inner_way_tags_filter(true) {
+                m_relation_tags_filter.add(false, "type").add(false, "created_by").add(false, "source").add(false, "note");
+                m_relation_tags_filter.add(false, "test:id").add(false, "test:section");
+                m_inner_way_tags_filter.add(false, "created_by").add(false, "source").add(false, "note");
+                m_inner_way_tags_filter.add(false, "test:id").add(false, "test:section");
             }
 
             ~Assembler() = default;
@@ -670,6 +818,8 @@ namespace osmium {
                     m_config.problem_reporter->set_object(osmium::item_type::way, way.id());
                 }
 
+                reset();
+
                 if (!way.ends_have_same_id()) {
                     if (m_config.problem_reporter) {
                         m_config.problem_reporter->report_duplicate_node(way.nodes().front().ref(), way.nodes().back().ref(), way.nodes().front().location());
@@ -677,6 +827,7 @@ namespace osmium {
                 }
 
                 m_segment_list.extract_segments_from_way(way, "outer");
+                m_ways.emplace_back(&way, "outer");
 
                 if (debug()) {
                     std::cerr << "\nBuild way id()=" << way.id() << " segments.size()=" << m_segment_list.size() << "\n";
@@ -707,7 +858,14 @@ namespace osmium {
                     m_config.problem_reporter->set_object(osmium::item_type::relation, relation.id());
                 }
 
+                reset();
+
                 m_segment_list.extract_segments_from_ways(relation, members, in_buffer);
+                auto member_it = relation.members().begin();
+                for (size_t offset : members) {
+                    m_ways.emplace_back(&in_buffer.get<const osmium::Way>(offset), member_it->role());
+                    ++member_it;
+                }
 
                 if (debug()) {
                     std::cerr << "\nBuild relation id()=" << relation.id() << " members.size()=" << members.size() << " segments.size()=" << m_segment_list.size() << "\n";
@@ -728,35 +886,37 @@ namespace osmium {
                 }
                 out_buffer.commit();
 
-                const osmium::TagList& area_tags = out_buffer.get<osmium::Area>(area_offset).tags(); // tags of the area we just built
-
-                if (m_inner_outer_mismatches == 0) {
-                    auto memit = relation.members().begin();
-                    for (size_t offset : members) {
-                        if (!std::strcmp(memit->role(), "inner")) {
-                            const osmium::Way& way = in_buffer.get<const osmium::Way>(offset);
-                            if (way.is_closed() && way.tags().size() > 0) {
-                                osmium::tags::KeyFilter filter(true);
-                                filter.add(false, "created_by").add(false, "source").add(false, "note");
-                                filter.add(false, "test:id").add(false, "test:section");
-
-                                osmium::tags::KeyFilter::iterator fi_begin(filter, way.tags().begin(), way.tags().end());
-                                osmium::tags::KeyFilter::iterator fi_end(filter, way.tags().end(), way.tags().end());
-
-                                auto d = std::distance(fi_begin, fi_end);
-                                if (d > 0) {
-                                    osmium::tags::KeyFilter::iterator area_fi_begin(filter, area_tags.begin(), area_tags.end());
-                                    osmium::tags::KeyFilter::iterator area_fi_end(filter, area_tags.end(), area_tags.end());
-
-                                    if (!std::equal(fi_begin, fi_end, area_fi_begin) || d != std::distance(area_fi_begin, area_fi_end)) {
-                                        Assembler assembler(m_config);
-                                        assembler(way, out_buffer);
-                                    }
+                if (m_inner_outer_mismatches != 0) {
+                    return;
+                }
+
+                // Inner ways with tags different from the area get an area
+                // of their own. This reuses this Assembler, so its state
+                // for the relation is gone after the first one.
+                auto memit = relation.members().begin();
+                for (size_t offset : members) {
+                    if (!std::strcmp(memit->role(), "inner")) {
+                        const osmium::Way& way = in_buffer.get<const osmium::Way>(offset);
+                        if (way.is_closed() && way.tags().size() > 0) {
+                            osmium::tags::KeyFilter::iterator fi_begin(m_inner_way_tags_filter, way.tags().begin(), way.tags().end());
+                            osmium::tags::KeyFilter::iterator fi_end(m_inner_way_tags_filter, way.tags().end(), way.tags().end());
+
+                            auto d = std::distance(fi_begin, fi_end);
+                            if (d > 0) {
+                                // tags of the area we just built, get them
+                                // again each time, because the buffer might
+                                // have been reallocated
+                                const osmium::TagList& area_tags = out_buffer.get<osmium::Area>(area_offset).tags();
+                                osmium::tags::KeyFilter::iterator area_fi_begin(m_inner_way_tags_filter, area_tags.begin(), area_tags.end());
+                                osmium::tags::KeyFilter::iterator area_fi_end(m_inner_way_tags_filter, area_tags.end(), area_tags.end());
+
+                                if (!std::equal(fi_begin, fi_end, area_fi_begin) || d != std::distance(area_fi_begin, area_fi_end)) {
+                                    (*this)(way, out_buffer);
                                 }
                             }
                         }
-                        ++memit;
                     }
+                    ++memit;
                 }
             }
 
@@ -40,7 +40,9 @@ DEALINGS IN THE SOFTWARE.
 #include <set>
 #include <vector>
 
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/way.hpp>
 #include <osmium/area/detail/node_ref_segment.hpp>
 
 namespace osmium {
@@ -68,6 +70,9 @@ namespace osmium {
                 // if this is an outer ring, these point to it's inner rings (if any)
                 std::vector<ProtoRing*> m_inner {};
 
+                // bounding box, only valid after update_bounding_box() was called
+                osmium::Box m_bounding_box {};
+
             public:
 
                 explicit ProtoRing(const NodeRefSegment& segment) :
@@ -80,6 +85,26 @@ namespace osmium {
                     std::copy(sbegin, send, m_segments.begin());
                 }
 
+                /**
+                 * Create ring from all segments of a closed way, in the
+                 * order of the nodes in the way. The way must not contain
+                 * consecutive nodes with the same location.
+                 */
+                explicit ProtoRing(const osmium::Way& way, const char* role) :
+                    m_segments() {
+                    m_segments.reserve(way.nodes().size() - 1);
+                    const osmium::NodeRef* last_nr = nullptr;
+                    for (const osmium::NodeRef& nr : way.nodes()) {
+                        if (last_nr) {
+                            m_segments.emplace_back(*last_nr, nr, role, &way);
+                            if (m_segments.back().first().location() != last_nr->location()) {
+                                m_segments.back().swap_locations();
+                            }
+                        }
+                        last_nr = &nr;
+                    }
+                }
+
                 bool outer() const {
                     return m_outer;
                 }
@@ -230,8 +255,28 @@ namespace osmium {
                     }
                 }
 
+                /**
+                 * Calculate the bounding box of this ring. Call this once
+                 * the ring is complete. It is used by is_in() to quickly
+                 * rule out rings.
+                 */
+                void update_bounding_box() {
+                    m_bounding_box = osmium::Box();
+                    for (const auto& segment : m_segments) {
+                        m_bounding_box.extend(segment.first().location());
+                    }
+                }
+
+                const osmium::Box& bounding_box() const {
+                    return m_bounding_box;
+                }
+
                 bool is_in(ProtoRing* outer) {
                     osmium::Location testpoint = segments().front().first().location();
+                    if (outer->bounding_box() && !outer->bounding_box().contains(testpoint)) {
+                        return false;
+                    }
+
                     bool is_in = false;
 
                     for (size_t i = 0, j = outer->segments().size()-1; i < outer->segments().size(); j = i++) {
@@ -244,7 +289,8 @@ namespace osmium {
                     return is_in;
                 }
 
-                void get_ways(std::set<const osmium::Way*>& ways) {
+                template <class TWaySet>
+                void get_ways(TWaySet& ways) const {
                     for (const auto& segment : m_segments) {
                         ways.insert(segment.way());
                     }
@@ -35,7 +35,13 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <queue>
+#include <set>
+#include <utility>
 #include <vector>
 
 #include <osmium/area/problem_reporter.hpp>
@@ -60,6 +66,12 @@ namespace osmium {
 
                 slist_type m_segments {};
 
+                // sorted y coordinates of all segment ends, see build_y_index()
+                std::vector<int32_t> m_y_coordinates {};
+
+                // segment tree over m_y_coordinates with segment indexes
+                std::vector<std::vector<uint32_t>> m_y_index {};
+
                 bool m_debug;
 
             public:
@@ -95,6 +107,10 @@ namespace osmium {
                     return m_segments.end();
                 }
 
+                const NodeRefSegment& operator[](size_t n) const {
+                    return m_segments[n];
+                }
+
                 /**
                  * Enable or disable debug output to stderr. This is for Osmium
                  * developers only.
@@ -106,6 +122,8 @@ namespace osmium {
                 /// Clear the list of segments. All segments are removed.
                 void clear() {
                     m_segments.clear();
+                    m_y_coordinates.clear();
+                    m_y_index.clear();
                 }
 
                 /// Sort the list of segments.
@@ -163,6 +181,70 @@ namespace osmium {
                     }
                 }
 
+                /**
+                 * Build an index over the y ranges of the segments for
+                 * for_each_segment_at(). Call this after the list is sorted
+                 * and before it is changed again.
+                 */
+                void build_y_index() {
+                    m_y_coordinates.clear();
+                    m_y_coordinates.reserve(m_segments.size() * 2);
+                    for (const auto& segment : m_segments) {
+                        m_y_coordinates.push_back(segment.first().location().y());
+                        m_y_coordinates.push_back(segment.second().location().y());
+                    }
+                    std::sort(m_y_coordinates.begin(), m_y_coordinates.end());
+                    m_y_coordinates.erase(std::unique(m_y_coordinates.begin(), m_y_coordinates.end()), m_y_coordinates.end());
+
+                    size_t tree_size = 1;
+                    while (tree_size < m_y_coordinates.size()) {
+                        tree_size <<= 1;
+                    }
+                    m_y_index.assign(tree_size * 2, std::vector<uint32_t>());
+
+                    // Segments are added in order, so the segment indexes in
+                    // each node are sorted by the x coordinate of their first
+                    // location.
+                    for (size_t n = 0; n < m_segments.size(); ++n) {
+                        const std::pair<int32_t, int32_t> yrange = std::minmax(m_segments[n].first().location().y(), m_segments[n].second().location().y());
+                        size_t l = y_coordinate_index(yrange.first) + tree_size;
+                        size_t r = y_coordinate_index(yrange.second) + tree_size + 1;
+                        while (l < r) {
+                            if (l & 1) {
+                                m_y_index[l++].push_back(static_cast<uint32_t>(n));
+                            }
+                            if (r & 1) {
+                                m_y_index[--r].push_back(static_cast<uint32_t>(n));
+                            }
+                            l >>= 1;
+                            r >>= 1;
+                        }
+                    }
+                }
+
+                /**
+                 * Call func(n) with the index n of every segment whose y
+                 * range contains the y coordinate of the location and whose
+                 * first location is not to the right of the location. The
+                 * location must be one of the segment ends and
+                 * build_y_index() must have been called before.
+                 */
+                template <class TFunc>
+                void for_each_segment_at(const osmium::Location location, TFunc&& func) const {
+                    assert(!m_y_index.empty());
+                    const size_t n = y_coordinate_index(location.y());
+                    assert(n < m_y_coordinates.size() && m_y_coordinates[n] == location.y());
+
+                    for (size_t node = n + m_y_index.size() / 2; node > 0; node >>= 1) {
+                        for (const uint32_t index : m_y_index[node]) {
+                            if (m_segments[index].first().location().x() > location.x()) {
+                                break;
+                            }
+                            func(static_cast<size_t>(index));
+                        }
+                    }
+                }
+
                 /**
                  * Find intersection between segments.
                  *
@@ -174,35 +256,169 @@ namespace osmium {
                         return false;
                     }
 
-                    bool found_intersections = false;
+                    std::vector<std::pair<size_t, size_t>> intersecting;
+                    auto check = [this, &intersecting](size_t i1, size_t i2) {
+                        const NodeRefSegment& s1 = m_segments[i1];
+                        const NodeRefSegment& s2 = m_segments[i2];
+                        assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
+                        if (y_range_overlap(s1, s2) && calculate_intersection(s1, s2)) {
+                            intersecting.emplace_back(i1, i2);
+                        }
+                    };
+
+                    if (m_segments.size() < min_sweep_segments) {
+                        find_candidates_simple(check);
+                    } else {
+                        find_candidates_sweep(check);
+                        std::sort(intersecting.begin(), intersecting.end());
+                    }
+
+                    for (const auto& pair : intersecting) {
+                        const NodeRefSegment& s1 = m_segments[pair.first];
+                        const NodeRefSegment& s2 = m_segments[pair.second];
+                        osmium::Location intersection = calculate_intersection(s1, s2);
+                        if (m_debug) {
+                            std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
+                        }
+                        if (problem_reporter) {
+                            problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(), s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
+                        }
+                    }
+
+                    return !intersecting.empty();
+                }
+
+            private:
 
-                    for (auto it1 = m_segments.begin(); it1 != m_segments.end()-1; ++it1) {
-                        const NodeRefSegment& s1 = *it1;
-                        for (auto it2 = it1+1; it2 != m_segments.end(); ++it2) {
-                            const NodeRefSegment& s2 = *it2;
+                size_t y_coordinate_index(int32_t y) const {
+                    return static_cast<size_t>(std::lower_bound(m_y_coordinates.begin(), m_y_coordinates.end(), y) - m_y_coordinates.begin());
+                }
 
-                            assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
+                /**
+                 * Segment lists with fewer segments than this are checked
+                 * for intersections by comparing all segments with
+                 * overlapping x ranges. Larger ones use a sweep line.
+                 */
+                static constexpr size_t min_sweep_segments = 64;
 
-                            if (outside_x_range(s2, s1)) {
+                /**
+                 * Call func(i1, i2) with i1 < i2 for all pairs of segments
+                 * whose x ranges overlap. This is quadratic if there are
+                 * many long segments running east-west.
+                 */
+                template <class TFunc>
+                void find_candidates_simple(TFunc&& func) const {
+                    for (size_t i1 = 0; i1 < m_segments.size() - 1; ++i1) {
+                        for (size_t i2 = i1 + 1; i2 < m_segments.size(); ++i2) {
+                            if (outside_x_range(m_segments[i2], m_segments[i1])) {
                                 break;
                             }
+                            func(i1, i2);
+                        }
+                    }
+                }
 
-                            if (y_range_overlap(s1, s2)) {
-                                osmium::Location intersection = calculate_intersection(s1, s2);
-                                if (intersection) {
-                                    found_intersections = true;
-                                    if (m_debug) {
-                                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
-                                    }
-                                    if (problem_reporter) {
-                                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(), s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
-                                    }
+                /**
+                 * Call func(i1, i2) for all pairs of segments whose x
+                 * ranges overlap and whose y ranges overlap, in no
+                 * particular order. Pairs with only overlapping x ranges
+                 * may or may not be reported.
+                 *
+                 * A sweep line runs from west to east over the (sorted)
+                 * segments. Segments are active while the sweep line
+                 * crosses their x range. The y ranges of the active
+                 * segments are kept in a segment tree (for finding the
+                 * ranges containing the lower end of the y range of the
+                 * new segment) and in a set ordered by the lower end (for
+                 * finding the ranges starting inside it). This needs
+                 * O((n + k) log n) time for n segments and k pairs
+                 * with overlapping bounding boxes.
+                 */
+                template <class TFunc>
+                void find_candidates_sweep(TFunc&& func) const {
+                    const size_t num_segments = m_segments.size();
+
+                    // lower and upper end of the y range of each segment
+                    std::vector<std::pair<int32_t, int32_t>> yranges;
+                    yranges.reserve(num_segments);
+                    std::vector<int32_t> ycoords;
+                    ycoords.reserve(num_segments * 2);
+                    for (const auto& segment : m_segments) {
+                        const std::pair<int32_t, int32_t> yrange = std::minmax(segment.first().location().y(), segment.second().location().y());
+                        yranges.push_back(yrange);
+                        ycoords.push_back(yrange.first);
+                        ycoords.push_back(yrange.second);
+                    }
+                    std::sort(ycoords.begin(), ycoords.end());
+                    ycoords.erase(std::unique(ycoords.begin(), ycoords.end()), ycoords.end());
+
+                    auto ycoord_index = [&ycoords](int32_t y) {
+                        return static_cast<size_t>(std::lower_bound(ycoords.begin(), ycoords.end(), y) - ycoords.begin());
+                    };
+
+                    size_t tree_size = 1;
+                    while (tree_size < ycoords.size()) {
+                        tree_size <<= 1;
+                    }
+                    std::vector<std::vector<size_t>> tree(tree_size * 2);
+
+                    auto is_active = [this](size_t index, int32_t x) {
+                        return m_segments[index].second().location().x() >= x;
+                    };
+
+                    typedef std::pair<int32_t, size_t> xend_type;
+                    std::priority_queue<xend_type, std::vector<xend_type>, std::greater<xend_type>> active_by_xend;
+                    std::set<std::pair<int32_t, size_t>> active_by_ystart;
+
+                    for (size_t i2 = 0; i2 < num_segments; ++i2) {
+                        const int32_t x = m_segments[i2].first().location().x();
+                        while (!active_by_xend.empty() && active_by_xend.top().first < x) {
+                            const size_t i1 = active_by_xend.top().second;
+                            active_by_xend.pop();
+                            active_by_ystart.erase(std::make_pair(yranges[i1].first, i1));
+                        }
+
+                        const int32_t ymin = yranges[i2].first;
+                        const int32_t ymax = yranges[i2].second;
+                        const size_t lower = ycoord_index(ymin);
+
+                        // active segments whose y range contains ymin,
+                        // inactive ones are removed from the tree lazily
+                        for (size_t node = lower + tree_size; node > 0; node >>= 1) {
+                            auto& list = tree[node];
+                            for (size_t n = 0; n < list.size();) {
+                                if (is_active(list[n], x)) {
+                                    func(list[n], i2);
+                                    ++n;
+                                } else {
+                                    list[n] = list.back();
+                                    list.pop_back();
                                 }
                             }
                         }
-                    }
 
-                    return found_intersections;
+                        // active segments whose y range starts above ymin
+                        // but not above ymax
+                        for (auto it = active_by_ystart.upper_bound(std::make_pair(ymin, num_segments));
+                             it != active_by_ystart.end() && it->first <= ymax; ++it) {
+                            func(it->second, i2);
+                        }
+
+                        active_by_xend.emplace(m_segments[i2].second().location().x(), i2);
+                        active_by_ystart.emplace(ymin, i2);
+                        size_t l = lower + tree_size;
+                        size_t r = ycoord_index(ymax) + tree_size + 1;
+                        while (l < r) {
+                            if (l & 1) {
+                                tree[l++].push_back(i2);
+                            }
+                            if (r & 1) {
+                                tree[--r].push_back(i2);
+                            }
+                            l >>= 1;
+                            r >>= 1;
+                        }
+                    }
                 }
 
             }; // class SegmentList
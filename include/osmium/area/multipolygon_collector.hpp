@@ -34,11 +34,18 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include <osmium/area/assemble_ways.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/relation.hpp>
@@ -46,6 +53,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/way.hpp>
 #include <osmium/relations/collector.hpp>
 #include <osmium/relations/detail/member_meta.hpp>
+#include <osmium/thread/pool.hpp>
 
 namespace osmium {
 
@@ -60,6 +68,85 @@ namespace osmium {
      */
     namespace area {
 
+        namespace detail {
+
+            /**
+             * Get a new id for an assembler config. Ids are never reused,
+             * so they tell configs apart even if one is allocated where
+             * an earlier one was.
+             */
+            inline size_t next_assembler_config_id() {
+                static std::atomic<size_t> id(0);
+                return ++id;
+            }
+
+            /**
+             * Pool task running the assembler on a copy of the data it
+             * needs. The input buffer either contains one relation
+             * followed by its members (in the order of the members in
+             * the relation) or any number of closed ways.
+             */
+            template <class TAssembler>
+            class AssemblerTask {
+
+                typedef typename TAssembler::config_type config_type;
+
+                const config_type* m_config;
+                size_t m_config_id;
+                osmium::memory::Buffer m_input;
+                bool m_is_relation;
+
+                static constexpr size_t initial_output_buffer_size = 64 * 1024;
+
+                /**
+                 * The assembler of this pool thread for the given config.
+                 * It is kept between tasks, so its arena and other
+                 * containers are only allocated once per thread. A new
+                 * one is created if the config changed.
+                 */
+                static TAssembler& assembler(const config_type& config, size_t config_id) {
+                    static thread_local std::unique_ptr<TAssembler> assembler;
+                    static thread_local size_t assembler_config_id = 0;
+                    if (!assembler || assembler_config_id != config_id) {
+                        assembler.reset(new TAssembler(config));
+                        assembler_config_id = config_id;
+                    }
+                    return *assembler;
+                }
+
+            public:
+
+                AssemblerTask(const config_type& config, size_t config_id, osmium::memory::Buffer&& input, bool is_relation) :
+                    m_config(&config),
+                    m_config_id(config_id),
+                    m_input(std::move(input)),
+                    m_is_relation(is_relation) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    osmium::memory::Buffer output(initial_output_buffer_size, osmium::memory::Buffer::auto_grow::yes);
+                    if (m_is_relation) {
+                        auto it = m_input.begin();
+                        const osmium::Relation& relation = static_cast<const osmium::Relation&>(*it);
+                        std::vector<size_t> offsets;
+                        for (++it; it != m_input.end(); ++it) {
+                            offsets.push_back(static_cast<size_t>(reinterpret_cast<const unsigned char*>(&*it) - m_input.data()));
+                        }
+                        try {
+                            assembler(*m_config, m_config_id)(relation, offsets, m_input, output);
+                        } catch (osmium::invalid_location&) {
+                            // XXX ignore
+                        }
+                    } else {
+                        assemble_closed_ways(assembler(*m_config, m_config_id), m_input, output);
+                    }
+                    return output;
+                }
+
+            }; // class AssemblerTask
+
+        } // namespace detail
+
         /**
          * This class collects all data needed for creating areas from
          * relations tagged with type=multipolygon or type=boundary.
@@ -67,7 +154,18 @@ namespace osmium {
          * osmium::relations::Collector.
          *
          * The actual assembling of the areas is done by the assembler
-         * class given as template argument.
+         * class given as template argument. Assembler objects are reused
+         * for many ways and relations.
+         *
+         * If the collector is created with parallel set to true, the
+         * assembler runs in the thread pool, each pool thread keeps its
+         * own assembler for the config of the collector. Each completed relation is
+         * copied together with its members into a task, closed ways
+         * not in any relation are batched up into tasks. The results
+         * are added to the output buffer in the same order as in the
+         * serial case. Because the problem reporters are not thread
+         * safe, the assembler always runs in the calling thread if
+         * a problem reporter or debug output is configured.
          *
          * @tparam TAssembler Multipolygon Assembler class.
          */
@@ -79,11 +177,67 @@ namespace osmium {
             typedef typename TAssembler::config_type assembler_config_type;
             const assembler_config_type m_assembler_config;
 
+            // Identifies m_assembler_config to the assemblers kept by
+            // the pool threads.
+            const size_t m_assembler_config_id;
+
+            // Assembler used for everything not done in the thread pool
+            TAssembler m_assembler;
+
             osmium::memory::Buffer m_output_buffer;
 
             static constexpr size_t initial_output_buffer_size = 1024 * 1024;
             static constexpr size_t max_buffer_size_for_flush = 100 * 1024;
 
+            // Closed ways are collected up to this size before they are
+            // sent to the thread pool in one task.
+            static constexpr size_t max_way_batch_size = 256 * 1024;
+
+            // Maximum number of assembler tasks in the thread pool.
+            static constexpr size_t max_pending_tasks = 100;
+
+            const bool m_parallel;
+
+            // Results of the assembler tasks in the order they have to
+            // end up in the output buffer.
+            std::deque<std::future<osmium::memory::Buffer>> m_pending;
+
+            // Closed ways not in any relation not yet sent to the pool.
+            osmium::memory::Buffer m_way_batch;
+
+            void submit(osmium::memory::Buffer&& input, bool is_relation) {
+                m_pending.push_back(osmium::thread::Pool::instance().submit(detail::AssemblerTask<TAssembler>(m_assembler_config, m_assembler_config_id, std::move(input), is_relation)));
+            }
+
+            void submit_way_batch() {
+                if (m_way_batch.committed() > 0) {
+                    osmium::memory::Buffer batch(max_way_batch_size, osmium::memory::Buffer::auto_grow::yes);
+                    std::swap(batch, m_way_batch);
+                    submit(std::move(batch), false);
+                }
+            }
+
+            /**
+             * Move results of finished tasks into the output buffer. Only
+             * the tasks at the front of the queue are looked at, so the
+             * order stays the same. If wait is true or too many tasks are
+             * pending, this waits for tasks to finish.
+             */
+            void collect_results(bool wait) {
+                while (!m_pending.empty()) {
+                    auto& future = m_pending.front();
+                    if (!wait && m_pending.size() <= max_pending_tasks &&
+                        future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                        return;
+                    }
+                    osmium::memory::Buffer result = future.get();
+                    m_pending.pop_front();
+                    m_output_buffer.add_buffer(result);
+                    m_output_buffer.commit();
+                    possibly_flush_output_buffer();
+                }
+            }
+
             void flush_output_buffer() {
                 if (this->callback()) {
                     this->callback()(m_output_buffer);
@@ -99,10 +253,23 @@ namespace osmium {
 
         public:
 
-            explicit MultipolygonCollector(const assembler_config_type& assembler_config) :
+            explicit MultipolygonCollector(const assembler_config_type& assembler_config, bool parallel = false) :
                 collector_type(),
                 m_assembler_config(assembler_config),
-                m_output_buffer(initial_output_buffer_size, osmium::memory::Buffer::auto_grow::yes) {
+                m_assembler_config_id(detail::next_assembler_config_id()),
+                m_assembler(m_assembler_config),
+                m_output_buffer(initial_output_buffer_size, osmium::memory::Buffer::auto_grow::yes),
+                m_parallel(parallel && !assembler_config.problem_reporter && !assembler_config.debug),
+                m_pending(),
+                m_way_batch(max_way_batch_size, osmium::memory::Buffer::auto_grow::yes) {
+            }
+
+            ~MultipolygonCollector() {
+                for (auto& future : m_pending) {
+                    if (future.valid()) {
+                        future.wait();
+                    }
+                }
             }
 
             /**
@@ -141,11 +308,19 @@ namespace osmium {
              * Overwritten from the base class.
              */
             void way_not_in_any_relation(const osmium::Way& way) {
-                if (way.ends_have_same_location() && way.nodes().size() > 3) {
+                if (way_can_be_area(way)) {
                     // way is closed and has enough nodes, build simple multipolygon
+                    if (m_parallel) {
+                        m_way_batch.add_item(way);
+                        m_way_batch.commit();
+                        if (m_way_batch.committed() > max_way_batch_size) {
+                            submit_way_batch();
+                            collect_results(false);
+                        }
+                        return;
+                    }
                     try {
-                        TAssembler assembler(m_assembler_config);
-                        assembler(way, m_output_buffer);
+                        m_assembler(way, m_output_buffer);
                         possibly_flush_output_buffer();
                     } catch (osmium::invalid_location&) {
                         // XXX ignore
@@ -155,18 +330,32 @@ namespace osmium {
 
             void complete_relation(osmium::relations::RelationMeta& relation_meta) {
                 const osmium::Relation& relation = this->get_relation(relation_meta);
+                const size_t relation_pos = static_cast<size_t>(&relation_meta - this->relations().data());
+                assert(relation_pos < this->relations().size());
                 std::vector<size_t> offsets;
                 for (const auto& member : relation.members()) {
                     if (member.ref() != 0) {
                         offsets.push_back(this->get_offset(member.type(), member.ref()));
                     }
                 }
-                try {
-                    TAssembler assembler(m_assembler_config);
-                    assembler(relation, offsets, this->members_buffer(), m_output_buffer);
-                    possibly_flush_output_buffer();
-                } catch (osmium::invalid_location&) {
-                    // XXX ignore
+                if (m_parallel) {
+                    submit_way_batch();
+                    osmium::memory::Buffer input(relation.byte_size() + 16 * 1024, osmium::memory::Buffer::auto_grow::yes);
+                    input.add_item(relation);
+                    input.commit();
+                    for (const size_t offset : offsets) {
+                        input.add_item(this->get_member(offset));
+                        input.commit();
+                    }
+                    submit(std::move(input), true);
+                    collect_results(false);
+                } else {
+                    try {
+                        m_assembler(relation, offsets, this->members_buffer(), m_output_buffer);
+                        possibly_flush_output_buffer();
+                    } catch (osmium::invalid_location&) {
+                        // XXX ignore
+                    }
                 }
 
                 // clear member metas
@@ -178,13 +367,15 @@ namespace osmium {
 
                         // if this is the last time this object was needed
                         // then mark it as removed
-                        if (range.first + 1 == range.second) {
-                            this->get_member(range.first->buffer_offset()).removed(true);
+                        if (std::count_if(range.first, range.second, [](const osmium::relations::MemberMeta& mm) {
+                            return !mm.removed();
+                        }) == 1) {
+                            this->remove_member(range.first->buffer_offset());
                         }
 
                         for (auto it = range.first; it != range.second; ++it) {
-                            if (relation.id() == this->get_relation(it->relation_pos()).id()) {
-                                mmv.erase(it);
+                            if (!it->removed() && it->relation_pos() == relation_pos) {
+                                this->remove_member_meta(member.type(), *it);
                                 break;
                             }
                         }
@@ -193,10 +384,13 @@ namespace osmium {
             }
 
             void flush() {
+                submit_way_batch();
+                collect_results(true);
                 flush_output_buffer();
             }
 
             osmium::memory::Buffer read() {
+                collect_results(false);
                 osmium::memory::Buffer buffer(initial_output_buffer_size, osmium::memory::Buffer::auto_grow::yes);
                 std::swap(buffer, m_output_buffer);
                 return buffer;
@@ -0,0 +1,344 @@
+#ifndef OSMIUM_GEOM_CLIP_HPP
+#define OSMIUM_GEOM_CLIP_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <osmium/geom/coordinates.hpp>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * An axis-parallel box in projected coordinates that linestrings
+         * and rings can be clipped to. Linestrings are clipped with the
+         * Cohen-Sutherland algorithm, rings with the Sutherland-Hodgman
+         * algorithm.
+         *
+         * Clipped rings can contain segments running along the border
+         * of the box, and inner rings can touch their outer ring there.
+         * This is the usual behaviour when cutting geometries into tiles.
+         */
+        class ClipBox {
+
+            enum outcode_type : unsigned {
+                inside = 0,
+                left   = 1,
+                right  = 2,
+                bottom = 4,
+                top    = 8
+            };
+
+            Coordinates m_min;
+            Coordinates m_max;
+
+            // scratch buffers for clipping rings
+            std::vector<Coordinates> m_buffer1 {};
+            std::vector<Coordinates> m_buffer2 {};
+
+            unsigned outcode(const Coordinates& c) const {
+                unsigned code = inside;
+                if (c.x < m_min.x) {
+                    code |= left;
+                } else if (c.x > m_max.x) {
+                    code |= right;
+                }
+                if (c.y < m_min.y) {
+                    code |= bottom;
+                } else if (c.y > m_max.y) {
+                    code |= top;
+                }
+                return code;
+            }
+
+            /**
+             * Combine the outcodes of count coordinates. Returns the
+             * bitwise and of all outcodes, which is not inside if all
+             * coordinates are outside on the same side. The bitwise or,
+             * which is inside if all coordinates are inside, is written
+             * to code_or.
+             */
+            unsigned outcode_and(const Coordinates* coordinates, size_t count, unsigned& code_or) const {
+                unsigned code_and = left | right | bottom | top;
+                code_or = inside;
+                for (size_t i = 0; i < count; ++i) {
+                    const unsigned code = outcode(coordinates[i]);
+                    code_and &= code;
+                    code_or |= code;
+                }
+                return code_and;
+            }
+
+            static void push_unique(std::vector<Coordinates>& out, const Coordinates& c) {
+                if (out.empty() || out.back() != c) {
+                    out.push_back(c);
+                }
+            }
+
+            static Coordinates intersect_x(const Coordinates& a, const Coordinates& b, double x) {
+                return Coordinates{x, a.y + (b.y - a.y) * (x - a.x) / (b.x - a.x)};
+            }
+
+            static Coordinates intersect_y(const Coordinates& a, const Coordinates& b, double y) {
+                return Coordinates{a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y), y};
+            }
+
+            /**
+             * Clip the (open) polygon in to one side of the box. This is
+             * one step of the Sutherland-Hodgman algorithm.
+             */
+            template <class TInside, class TIntersect>
+            static void clip_side(const std::vector<Coordinates>& in, std::vector<Coordinates>& out, TInside&& is_inside, TIntersect&& intersect) {
+                out.clear();
+                if (in.empty()) {
+                    return;
+                }
+                const Coordinates* prev = &in.back();
+                bool prev_inside = is_inside(*prev);
+                for (const Coordinates& c : in) {
+                    const bool c_inside = is_inside(c);
+                    if (c_inside != prev_inside) {
+                        out.push_back(intersect(*prev, c));
+                    }
+                    if (c_inside) {
+                        out.push_back(c);
+                    }
+                    prev = &c;
+                    prev_inside = c_inside;
+                }
+            }
+
+            static double ring_area2(const std::vector<Coordinates>& ring) {
+                double sum = 0.0;
+                for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+                    sum += ring[j].x * ring[i].y - ring[i].x * ring[j].y;
+                }
+                return sum;
+            }
+
+        public:
+
+            /**
+             * Create a clip box from two opposite corners in projected
+             * coordinates.
+             */
+            ClipBox(const Coordinates& corner1, const Coordinates& corner2) :
+                m_min(std::min(corner1.x, corner2.x), std::min(corner1.y, corner2.y)),
+                m_max(std::max(corner1.x, corner2.x), std::max(corner1.y, corner2.y)) {
+            }
+
+            const Coordinates& min() const {
+                return m_min;
+            }
+
+            const Coordinates& max() const {
+                return m_max;
+            }
+
+            /**
+             * Clip the segment from a to b to the box. The end points
+             * are moved onto the border of the box if they are outside.
+             *
+             * @returns false if the segment is completely outside the box
+             */
+            bool clip_segment(Coordinates& a, Coordinates& b) const {
+                unsigned code_a = outcode(a);
+                unsigned code_b = outcode(b);
+
+                while (true) {
+                    if ((code_a | code_b) == inside) {
+                        return true;
+                    }
+                    if ((code_a & code_b) != inside) {
+                        return false;
+                    }
+
+                    const unsigned code = code_a != inside ? code_a : code_b;
+                    Coordinates c;
+                    if (code & top) {
+                        c = intersect_y(a, b, m_max.y);
+                    } else if (code & bottom) {
+                        c = intersect_y(a, b, m_min.y);
+                    } else if (code & right) {
+                        c = intersect_x(a, b, m_max.x);
+                    } else {
+                        c = intersect_x(a, b, m_min.x);
+                    }
+
+                    if (code == code_a) {
+                        a = c;
+                        code_a = outcode(a);
+                    } else {
+                        b = c;
+                        code_b = outcode(b);
+                    }
+                }
+            }
+
+            /**
+             * Clip a linestring to the box. The linestring can fall apart
+             * into several pieces. Their coordinates are appended to out,
+             * their number of points to parts. Pieces with less than two
+             * different points are left out.
+             *
+             * @returns number of pieces
+             */
+            size_t clip_linestring(const Coordinates* coordinates, size_t count, std::vector<Coordinates>& out, std::vector<size_t>& parts) const {
+                unsigned code_or;
+                const unsigned code_and = outcode_and(coordinates, count, code_or);
+                if (code_and != inside) {
+                    return 0;
+                }
+                if (code_or == inside) {
+                    out.insert(out.end(), coordinates, coordinates + count);
+                    parts.push_back(count);
+                    return 1;
+                }
+
+                const size_t num_parts = parts.size();
+                size_t start = out.size();
+                for (size_t i = 1; i < count; ++i) {
+                    Coordinates a = coordinates[i - 1];
+                    Coordinates b = coordinates[i];
+                    if (!clip_segment(a, b)) {
+                        continue;
+                    }
+                    if (out.size() == start || out.back() != a) {
+                        if (out.size() - start >= 2) {
+                            parts.push_back(out.size() - start);
+                        } else {
+                            out.resize(start);
+                        }
+                        start = out.size();
+                        out.push_back(a);
+                    }
+                    push_unique(out, b);
+                }
+
+                if (out.size() - start >= 2) {
+                    parts.push_back(out.size() - start);
+                } else {
+                    out.resize(start);
+                }
+
+                return parts.size() - num_parts;
+            }
+
+            /**
+             * Clip a closed ring to the box and append the result to out.
+             * Rings without any area left are dropped.
+             *
+             * @returns number of points added (0 if ring was dropped)
+             */
+            size_t clip_ring(const Coordinates* coordinates, size_t count, std::vector<Coordinates>& out) {
+                unsigned code_or;
+                const unsigned code_and = outcode_and(coordinates, count, code_or);
+                if (code_and != inside || count < 4) {
+                    return 0;
+                }
+                if (code_or == inside) {
+                    out.insert(out.end(), coordinates, coordinates + count);
+                    return count;
+                }
+
+                // work on the open ring without the closing point
+                m_buffer1.assign(coordinates, coordinates + count - 1);
+
+                if (code_or & left) {
+                    clip_side(m_buffer1, m_buffer2, [this](const Coordinates& c) {
+                        return c.x >= m_min.x;
+                    }, [this](const Coordinates& a, const Coordinates& b) {
+                        return intersect_x(a, b, m_min.x);
+                    });
+                    std::swap(m_buffer1, m_buffer2);
+                }
+                if (code_or & right) {
+                    clip_side(m_buffer1, m_buffer2, [this](const Coordinates& c) {
+                        return c.x <= m_max.x;
+                    }, [this](const Coordinates& a, const Coordinates& b) {
+                        return intersect_x(a, b, m_max.x);
+                    });
+                    std::swap(m_buffer1, m_buffer2);
+                }
+                if (code_or & bottom) {
+                    clip_side(m_buffer1, m_buffer2, [this](const Coordinates& c) {
+                        return c.y >= m_min.y;
+                    }, [this](const Coordinates& a, const Coordinates& b) {
+                        return intersect_y(a, b, m_min.y);
+                    });
+                    std::swap(m_buffer1, m_buffer2);
+                }
+                if (code_or & top) {
+                    clip_side(m_buffer1, m_buffer2, [this](const Coordinates& c) {
+                        return c.y <= m_max.y;
+                    }, [this](const Coordinates& a, const Coordinates& b) {
+                        return intersect_y(a, b, m_max.y);
+                    });
+                    std::swap(m_buffer1, m_buffer2);
+                }
+
+                m_buffer2.clear();
+                for (const Coordinates& c : m_buffer1) {
+                    push_unique(m_buffer2, c);
+                }
+                while (m_buffer2.size() > 1 && m_buffer2.back() == m_buffer2.front()) {
+                    m_buffer2.pop_back();
+                }
+
+                if (m_buffer2.size() < 3 || ring_area2(m_buffer2) == 0.0) {
+                    return 0;
+                }
+
+                // start with the same point as the original ring if it is
+                // still there
+                const auto first = std::find(m_buffer2.begin(), m_buffer2.end(), coordinates[0]);
+                if (first != m_buffer2.end()) {
+                    std::rotate(m_buffer2.begin(), first, m_buffer2.end());
+                }
+
+                out.insert(out.end(), m_buffer2.begin(), m_buffer2.end());
+                out.push_back(m_buffer2.front());
+                return m_buffer2.size() + 1;
+            }
+
+        }; // class ClipBox
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_CLIP_HPP
@@ -33,11 +33,14 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 #include <string>
 
 #include <osmium/osm/location.hpp>
+#include <osmium/util/double.hpp>
 
 namespace osmium {
 
@@ -46,17 +49,66 @@ namespace osmium {
         namespace detail {
 
             /**
-             * Append double to string, removing superfluous '0' characters at
-             * the end. The decimal dot will also be removed if necessary.
+             * Append value / 10^7 to string without trailing '0'
+             * characters after the decimal dot. The decimal dot will also
+             * be left out if there are no decimals. This is exact for the
+             * fixed point coordinates of osmium::Location.
              */
-            inline void double2string(std::string& s, double value) {
-                s += std::to_string(value);
-
-                size_t len = s.size()-1;
-                while (s[len] == '0') --len;
-                if (s[len] == '.') --len;
+            inline void fixed2string(std::string& s, int64_t value) {
+                char buffer[24];
+                char* const end = buffer + sizeof(buffer);
+                char* p = end;
+
+                const bool negative = value < 0;
+                uint64_t v = negative ? -static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+                uint64_t fraction = v % osmium::Location::coordinate_precision;
+                v /= osmium::Location::coordinate_precision;
+
+                if (fraction != 0) {
+                    int digits = 7;
+                    while (fraction % 10 == 0) {
+                        fraction /= 10;
+                        --digits;
+                    }
+                    for (; digits > 0; --digits) {
+                        *--p = static_cast<char>('0' + fraction % 10);
+                        fraction /= 10;
+                    }
+                    *--p = '.';
+                }
+
+                do {
+                    *--p = static_cast<char>('0' + v % 10);
+                    v /= 10;
+                } while (v != 0);
+
+                if (negative) {
+                    *--p = '-';
+                }
+
+                s.append(p, static_cast<size_t>(end - p));
+            }
 
-                s.resize(len+1);
+            /**
+             * Append double to string using as few digits as possible
+             * while still being able to read back exactly the same value.
+             *
+             * Values that are a multiple of 10^-7, like all coordinates
+             * of unprojected locations, are written with fixed2string(),
+             * which is exact and much faster. Others, like projected
+             * coordinates, with osmium::util::double2string().
+             */
+            inline void double2string(std::string& s, double value) {
+                const double scaled = value * osmium::Location::coordinate_precision;
+                if (std::abs(scaled) < 1e15) {
+                    const int64_t fixed = std::llround(scaled);
+                    if (static_cast<double>(fixed) / osmium::Location::coordinate_precision == value) {
+                        fixed2string(s, fixed);
+                        return;
+                    }
+                }
+
+                osmium::util::double2string(s, value);
             }
 
         } // namespace detail
@@ -66,6 +118,9 @@ namespace osmium {
             double x;
             double y;
 
+            Coordinates() : x(0.0), y(0.0) {
+            }
+
             explicit Coordinates(double cx, double cy) : x(cx), y(cy) {
             }
 
@@ -0,0 +1,205 @@
+#ifndef OSMIUM_GEOM_COPY_WRITER_HPP
+#define OSMIUM_GEOM_COPY_WRITER_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <osmium/io/detail/read_write.hpp>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Writes rows in the text format of the PostgreSQL COPY command
+         * to a file descriptor. Rows are collected in a buffer and
+         * written out whenever the buffer is larger than flush_size
+         * after a row is finished.
+         *
+         * Geometries are added by giving buffer() to one of the append
+         * factories (for instance WKBAppendFactory with hex output) and
+         * calling it after add_column():
+         *
+         * @code
+         * osmium::geom::CopyWriter writer(fd);
+         * osmium::geom::WKBAppendFactory<> factory(writer.buffer(), wkb_type::ewkb, out_type::hex);
+         * writer.add(way.id());
+         * writer.add_column();
+         * factory.create_linestring(way);
+         * writer.end_row();
+         * @endcode
+         *
+         * The factories don't write anything if they throw an exception.
+         * Call abort_row() in that case to remove the rest of the row.
+         */
+        class CopyWriter {
+
+            int m_fd;
+            size_t m_flush_size;
+            std::string m_buffer {};
+
+            // start of the current row in m_buffer
+            size_t m_row_start {0};
+
+            bool m_first_column {true};
+
+        public:
+
+            explicit CopyWriter(int fd, size_t flush_size = 1024 * 1024) :
+                m_fd(fd),
+                m_flush_size(flush_size) {
+                m_buffer.reserve(flush_size + flush_size / 8);
+            }
+
+            CopyWriter(const CopyWriter&) = delete;
+            CopyWriter& operator=(const CopyWriter&) = delete;
+
+            /**
+             * Write out all complete rows. Errors are ignored here,
+             * call flush() before to see them.
+             */
+            ~CopyWriter() {
+                try {
+                    flush();
+                } catch (...) {
+                    // ignore errors in destructor
+                }
+            }
+
+            /// The buffer the rows are collected in.
+            std::string& buffer() {
+                return m_buffer;
+            }
+
+            /**
+             * Start a new column. Anything appended to buffer() until the
+             * next column or the end of the row is written as is, so it
+             * must not contain tabs, newlines or backslashes.
+             */
+            std::string& add_column() {
+                if (m_first_column) {
+                    m_first_column = false;
+                } else {
+                    m_buffer += '\t';
+                }
+                return m_buffer;
+            }
+
+            /// Add a column with the value NULL.
+            CopyWriter& add_null() {
+                add_column() += "\\N";
+                return *this;
+            }
+
+            /// Add a text column. Special characters are escaped.
+            CopyWriter& add(const char* value) {
+                add_column();
+                for (; *value; ++value) {
+                    switch (*value) {
+                        case '\\':
+                            m_buffer += "\\\\";
+                            break;
+                        case '\t':
+                            m_buffer += "\\t";
+                            break;
+                        case '\n':
+                            m_buffer += "\\n";
+                            break;
+                        case '\r':
+                            m_buffer += "\\r";
+                            break;
+                        default:
+                            m_buffer += *value;
+                    }
+                }
+                return *this;
+            }
+
+            CopyWriter& add(const std::string& value) {
+                return add(value.c_str());
+            }
+
+            /// Add an integer column.
+            CopyWriter& add(int64_t value) {
+                char buffer[24];
+                const int length = std::snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+                add_column().append(buffer, static_cast<size_t>(length));
+                return *this;
+            }
+
+            /**
+             * Finish the current row. Writes out the buffer if it is
+             * larger than flush_size.
+             *
+             * @throws std::system_error If the write failed
+             */
+            void end_row() {
+                m_buffer += '\n';
+                m_row_start = m_buffer.size();
+                m_first_column = true;
+                if (m_buffer.size() >= m_flush_size) {
+                    flush();
+                }
+            }
+
+            /// Remove everything added since the end of the last row.
+            void abort_row() {
+                m_buffer.resize(m_row_start);
+                m_first_column = true;
+            }
+
+            /**
+             * Write out all complete rows.
+             *
+             * @throws std::system_error If the write failed
+             */
+            void flush() {
+                if (m_row_start > 0) {
+                    osmium::io::detail::reliable_write(m_fd, m_buffer.data(), m_row_start);
+                    m_buffer.erase(0, m_row_start);
+                    m_row_start = 0;
+                }
+            }
+
+        }; // class CopyWriter
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_COPY_WRITER_HPP
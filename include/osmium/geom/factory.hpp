@@ -33,14 +33,19 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstddef>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#include <osmium/geom/clip.hpp>
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/memory/collection.hpp>
 #include <osmium/memory/item.hpp>
 #include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
@@ -95,6 +100,12 @@ namespace osmium {
                 return Coordinates{location.lon(), location.lat()};
             }
 
+            void project(const osmium::Location* locations, Coordinates* coordinates, size_t count) const {
+                for (size_t i = 0; i < count; ++i) {
+                    coordinates[i] = Coordinates{locations[i].lon(), locations[i].lat()};
+                }
+            }
+
             int epsg() const {
                 return 4326;
             }
@@ -105,6 +116,190 @@ namespace osmium {
 
         }; // class IdentityProjection
 
+        namespace detail {
+
+            /**
+             * Project count locations using the batch interface
+             * project(locations, coordinates, count) of the projection.
+             */
+            template <class TProjection>
+            inline auto project(const TProjection& projection, const osmium::Location* locations, Coordinates* coordinates, size_t count, int) -> decltype(projection.project(locations, coordinates, count), void()) {
+                projection.project(locations, coordinates, count);
+            }
+
+            /**
+             * Project count locations one by one for projections without
+             * a batch interface.
+             */
+            template <class TProjection>
+            inline void project(const TProjection& projection, const osmium::Location* locations, Coordinates* coordinates, size_t count, long) {
+                for (size_t i = 0; i < count; ++i) {
+                    coordinates[i] = projection(locations[i]);
+                }
+            }
+
+            /**
+             * Add count coordinates to a linestring in one go if the
+             * geometry implementation has linestring_add_locations().
+             */
+            template <class TGeomImpl>
+            inline auto linestring_add_locations(TGeomImpl& impl, const Coordinates* coordinates, size_t count, int) -> decltype(impl.linestring_add_locations(coordinates, count), void()) {
+                impl.linestring_add_locations(coordinates, count);
+            }
+
+            /**
+             * Add count coordinates to a linestring one by one.
+             */
+            template <class TGeomImpl>
+            inline void linestring_add_locations(TGeomImpl& impl, const Coordinates* coordinates, size_t count, long) {
+                for (size_t i = 0; i < count; ++i) {
+                    impl.linestring_add_location(coordinates[i]);
+                }
+            }
+
+            /**
+             * Add count coordinates to a ring of a multipolygon in one go
+             * if the geometry implementation has
+             * multipolygon_add_locations().
+             */
+            template <class TGeomImpl>
+            inline auto multipolygon_add_locations(TGeomImpl& impl, const Coordinates* coordinates, size_t count, int) -> decltype(impl.multipolygon_add_locations(coordinates, count), void()) {
+                impl.multipolygon_add_locations(coordinates, count);
+            }
+
+            /**
+             * Add count coordinates to a ring of a multipolygon one by
+             * one.
+             */
+            template <class TGeomImpl>
+            inline void multipolygon_add_locations(TGeomImpl& impl, const Coordinates* coordinates, size_t count, long) {
+                for (size_t i = 0; i < count; ++i) {
+                    impl.multipolygon_add_location(coordinates[i]);
+                }
+            }
+
+            /**
+             * Checks whether the geometry implementation has
+             * linestring_add_locations() and multipolygon_add_locations()
+             * taking unprojected locations and the projection. It can
+             * then project them straight into its own geometry instead
+             * of getting them from the buffer of the GeometryFactory.
+             */
+            template <class TGeomImpl, class TProjection>
+            class projects_locations {
+
+                template <class T>
+                static auto check(int) -> decltype(std::declval<T&>().linestring_add_locations(std::declval<const osmium::Location*>(), size_t(), std::declval<const TProjection&>()),
+                                                   std::declval<T&>().multipolygon_add_locations(std::declval<const osmium::Location*>(), size_t(), std::declval<const TProjection&>()),
+                                                   std::true_type());
+
+                template <class T>
+                static std::false_type check(long);
+
+            public:
+
+                static constexpr bool value = decltype(check<TGeomImpl>(0))::value;
+
+            }; // class projects_locations
+
+            /**
+             * Call func with the geometry returned by make().
+             */
+            template <class TFunc, class TMake>
+            inline auto call_with_geometry(TFunc&& func, TMake&& make, int) -> decltype(func(make()), void()) {
+                func(make());
+            }
+
+            /**
+             * Call make() and then func without arguments for geometry
+             * implementations that don't return anything, because they
+             * append to some output.
+             */
+            template <class TFunc, class TMake>
+            inline void call_with_geometry(TFunc&& func, TMake&& make, long) {
+                make();
+                func();
+            }
+
+            /**
+             * Output policy for the string based geometry factory
+             * implementations: Each geometry is returned as a new
+             * std::string.
+             */
+            class StringOutput {
+
+                std::string m_str {};
+
+            public:
+
+                typedef std::string result_type;
+
+                /// Start a new geometry and return the string to write it to.
+                std::string& start() {
+                    m_str.clear();
+                    return m_str;
+                }
+
+                /// The string the current geometry is written to.
+                std::string& str() {
+                    return m_str;
+                }
+
+                result_type finish() {
+                    std::string str;
+                    std::swap(str, m_str);
+                    return str;
+                }
+
+                /// Create a geometry in one go by calling func(string).
+                template <class TFunc>
+                result_type write(TFunc&& func) const {
+                    std::string str;
+                    func(str);
+                    return str;
+                }
+
+            }; // class StringOutput
+
+            /**
+             * Output policy for the string based geometry factory
+             * implementations: Geometries are appended to a string owned
+             * by the caller. Nothing is returned. If the caller clears
+             * the string from time to time, for instance after writing
+             * it out, no memory is allocated once it is large enough.
+             */
+            class AppendOutput {
+
+                std::string* m_str;
+
+            public:
+
+                typedef void result_type;
+
+                explicit AppendOutput(std::string& str) :
+                    m_str(&str) {
+                }
+
+                std::string& start() {
+                    return *m_str;
+                }
+
+                std::string& str() {
+                    return *m_str;
+                }
+
+                result_type finish() {
+                }
+
+                template <class TFunc>
+                result_type write(TFunc&& func) const {
+                    func(*m_str);
+                }
+
+            }; // class AppendOutput
+
+        } // namespace detail
+
         /**
          * Geometry factory.
          */
@@ -112,21 +307,186 @@ namespace osmium {
         class GeometryFactory {
 
             /**
-             * Add all points of an outer or inner ring to a multipolygon.
+             * Add the locations of all nodes of an outer or inner ring
+             * to m_locations, leaving out consecutive duplicates.
+             *
+             * @returns number of locations added
              */
-            void add_points(const osmium::OuterRing& nodes) {
+            size_t add_locations(const osmium::OuterRing& nodes) {
+                const size_t size = m_locations.size();
                 osmium::Location last_location;
                 for (const osmium::NodeRef& node_ref : nodes) {
                     if (last_location != node_ref.location()) {
                         last_location = node_ref.location();
-                        m_impl.multipolygon_add_location(m_projection(last_location));
+                        m_locations.push_back(last_location);
+                    }
+                }
+                return m_locations.size() - size;
+            }
+
+            typedef std::integral_constant<bool, detail::projects_locations<TGeomImpl, TProjection>::value> impl_projects_type;
+
+            /**
+             * Does the geometry implementation project the locations in
+             * m_locations itself? Not if they have to be clipped.
+             */
+            bool impl_projects() const {
+                return impl_projects_type::value && !m_clip;
+            }
+
+            /**
+             * Add count points starting at offset in m_locations to a
+             * multipolygon, projected by the geometry implementation.
+             */
+            void add_points(size_t offset, size_t count, std::true_type) {
+                m_impl.multipolygon_add_locations(m_locations.data() + offset, count, m_projection);
+            }
+
+            /**
+             * Add count points starting at offset in m_coordinates to a
+             * multipolygon.
+             */
+            void add_points(size_t offset, size_t count, std::false_type) {
+                detail::multipolygon_add_locations(m_impl, m_coordinates.data() + offset, count, 0);
+            }
+
+            void add_points(size_t offset, size_t count) {
+                if (impl_projects()) {
+                    add_points(offset, count, impl_projects_type());
+                } else {
+                    add_points(offset, count, std::false_type());
+                }
+            }
+
+            /**
+             * Project all locations in m_locations into m_coordinates
+             * in one go.
+             */
+            void project_locations() {
+                m_coordinates.resize(m_locations.size());
+                detail::project(m_projection, m_locations.data(), m_coordinates.data(), m_locations.size(), 0);
+            }
+
+            /**
+             * Put the projected locations of the way nodes into
+             * m_coordinates and, if there is a clip box, the clipped
+             * pieces into m_clipped and m_parts. The locations are only
+             * left in m_locations if the geometry implementation projects
+             * them itself.
+             */
+            void prepare_linestring(const osmium::WayNodeList& wnl, use_nodes un, direction dir) {
+                m_locations.clear();
+
+                if (un == use_nodes::unique) {
+                    switch (dir) {
+                        case direction::forward:
+                            add_locations_unique(wnl.cbegin(), wnl.cend());
+                            break;
+                        case direction::backward:
+                            add_locations_unique(wnl.crbegin(), wnl.crend());
+                            break;
+                    }
+                } else {
+                    switch (dir) {
+                        case direction::forward:
+                            add_locations(wnl.cbegin(), wnl.cend());
+                            break;
+                        case direction::backward:
+                            add_locations(wnl.crbegin(), wnl.crend());
+                            break;
+                    }
+                }
+
+                if (m_locations.size() < 2) {
+                    throw geometry_error("not enough points for linestring");
+                }
+
+                if (impl_projects()) {
+                    return;
+                }
+
+                project_locations();
+
+                if (m_clip) {
+                    m_clipped.clear();
+                    m_parts.clear();
+                    m_clip_box.clip_linestring(m_coordinates.data(), m_coordinates.size(), m_clipped, m_parts);
+                }
+            }
+
+            typename TGeomImpl::linestring_type make_linestring(const Coordinates* coordinates, size_t count) {
+                m_impl.linestring_start();
+                detail::linestring_add_locations(m_impl, coordinates, count, 0);
+                return m_impl.linestring_finish(static_cast<int>(count));
+            }
+
+            typename TGeomImpl::linestring_type make_unclipped_linestring(std::true_type) {
+                m_impl.linestring_start();
+                m_impl.linestring_add_locations(m_locations.data(), m_locations.size(), m_projection);
+                return m_impl.linestring_finish(static_cast<int>(m_locations.size()));
+            }
+
+            typename TGeomImpl::linestring_type make_unclipped_linestring(std::false_type) {
+                return make_linestring(m_coordinates.data(), m_coordinates.size());
+            }
+
+            /**
+             * Make the linestring prepared by prepare_linestring() if
+             * there is no clip box.
+             */
+            typename TGeomImpl::linestring_type make_unclipped_linestring() {
+                return make_unclipped_linestring(impl_projects_type());
+            }
+
+            /**
+             * Clip the rings in m_coordinates described by m_rings and
+             * replace them by the clipped rings. Rings without area
+             * left are removed, inner rings are also removed if their
+             * outer ring is gone.
+             */
+            void clip_rings() {
+                m_clipped.clear();
+                const Coordinates* coordinates = m_coordinates.data();
+                bool keep_inner = false;
+                auto out = m_rings.begin();
+                for (const auto& ring : m_rings) {
+                    size_t count = 0;
+                    if (ring.first == osmium::item_type::outer_ring || keep_inner) {
+                        count = m_clip_box.clip_ring(coordinates, ring.second, m_clipped);
+                    }
+                    if (ring.first == osmium::item_type::outer_ring) {
+                        keep_inner = count > 0;
+                    }
+                    if (count > 0) {
+                        *out++ = std::make_pair(ring.first, count);
                     }
+                    coordinates += ring.second;
                 }
+                m_rings.erase(out, m_rings.end());
+                std::swap(m_coordinates, m_clipped);
             }
 
             TProjection m_projection;
             TGeomImpl m_impl;
 
+            // Buffers for projecting all locations of a linestring or
+            // area at once. They are kept to save on allocations.
+            std::vector<osmium::Location> m_locations {};
+            std::vector<Coordinates> m_coordinates {};
+
+            // Type (outer or inner) and number of points of the rings of
+            // an area
+            std::vector<std::pair<osmium::item_type, size_t>> m_rings {};
+
+            // Clip box, only used if m_clip is set
+            bool m_clip {false};
+            ClipBox m_clip_box {Coordinates{}, Coordinates{}};
+
+            // Clipped coordinates and number of points in each clipped
+            // linestring
+            std::vector<Coordinates> m_clipped {};
+            std::vector<size_t> m_parts {};
+
         public:
 
             GeometryFactory<TGeomImpl, TProjection>() = default;
@@ -164,6 +524,42 @@ namespace osmium {
                 return m_projection.proj_string();
             }
 
+            /**
+             * Clip all linestrings and multipolygons created from now on
+             * to the given box. The corners of the box are projected, so
+             * the clip box is exact for projections that map meridians
+             * and parallels to axis-parallel lines, like the Mercator
+             * projection. Clipping happens after projection, before the
+             * coordinates are handed to the geometry implementation.
+             *
+             * Points are never clipped.
+             *
+             * @throws osmium::invalid_location if the box is not defined
+             */
+            void set_clip_box(const osmium::Box& box) {
+                set_clip_box(m_projection(box.bottom_left()), m_projection(box.top_right()));
+            }
+
+            /**
+             * Clip all linestrings and multipolygons created from now on
+             * to the box with the given corners in projected coordinates.
+             */
+            void set_clip_box(const Coordinates& corner1, const Coordinates& corner2) {
+                m_clip_box = ClipBox{corner1, corner2};
+                m_clip = true;
+            }
+
+            /**
+             * Stop clipping.
+             */
+            void clear_clip_box() {
+                m_clip = false;
+            }
+
+            bool has_clip_box() const {
+                return m_clip;
+            }
+
             /* Point */
 
             point_type create_point(const osmium::Location location) const {
@@ -181,94 +577,151 @@ namespace osmium {
             /* LineString */
 
             template <class TIter>
-            int fill_linestring(TIter it, TIter end) {
-                int num_points = 0;
-                for (; it != end; ++it, ++num_points) {
-                    m_impl.linestring_add_location(m_projection(it->location()));
+            void add_locations(TIter it, TIter end) {
+                for (; it != end; ++it) {
+                    m_locations.push_back(it->location());
                 }
-                return num_points;
             }
 
             template <class TIter>
-            int fill_linestring_unique(TIter it, TIter end) {
-                int num_points = 0;
+            void add_locations_unique(TIter it, TIter end) {
                 osmium::Location last_location;
                 for (; it != end; ++it) {
                     if (last_location != it->location()) {
                         last_location = it->location();
-                        m_impl.linestring_add_location(m_projection(last_location));
-                        ++num_points;
+                        m_locations.push_back(last_location);
                     }
                 }
-                return num_points;
             }
 
+            /**
+             * Create a linestring. All checks and the projection are done
+             * before anything is handed to the geometry implementation,
+             * so it never sees a geometry that is later abandoned because
+             * of an exception. The exception are implementations that
+             * project the locations themselves (see
+             * detail::projects_locations), they have to cope with an
+             * exception from the projection.
+             *
+             * If a clip box is set and the linestring is completely
+             * outside or cut into several pieces by it, a geometry_error
+             * is thrown. Use create_linestrings() to get all pieces.
+             */
             linestring_type create_linestring(const osmium::WayNodeList& wnl, use_nodes un=use_nodes::unique, direction dir=direction::forward) {
-                m_impl.linestring_start();
-                int num_points = 0;
+                prepare_linestring(wnl, un, dir);
 
-                if (un == use_nodes::unique) {
-                    osmium::Location last_location;
-                    switch (dir) {
-                        case direction::forward:
-                            num_points = fill_linestring_unique(wnl.cbegin(), wnl.cend());
-                            break;
-                        case direction::backward:
-                            num_points = fill_linestring_unique(wnl.crbegin(), wnl.crend());
-                            break;
-                    }
-                } else {
-                    switch (dir) {
-                        case direction::forward:
-                            num_points = fill_linestring(wnl.cbegin(), wnl.cend());
-                            break;
-                        case direction::backward:
-                            num_points = fill_linestring(wnl.crbegin(), wnl.crend());
-                            break;
-                    }
+                if (!m_clip) {
+                    return make_unclipped_linestring();
                 }
 
-                if (num_points < 2) {
-                    throw geometry_error("not enough points for linestring");
+                if (m_parts.empty()) {
+                    throw geometry_error("linestring outside clip box");
+                }
+                if (m_parts.size() > 1) {
+                    throw geometry_error("linestring cut into several pieces by clip box");
+                }
+                return make_linestring(m_clipped.data(), m_clipped.size());
+            }
+
+            /**
+             * Create linestrings from a way node list and call
+             * func(linestring) for each one. Without clip box, this is
+             * the same linestring create_linestring() returns. With a
+             * clip box, the linestring is cut into the pieces inside the
+             * box. If the geometry implementation does not return
+             * linestrings, because it appends them to some output,
+             * func() is called without arguments after each piece.
+             *
+             * @returns number of linestrings created
+             */
+            template <class TFunc>
+            size_t create_linestrings(const osmium::WayNodeList& wnl, TFunc&& func, use_nodes un=use_nodes::unique, direction dir=direction::forward) {
+                prepare_linestring(wnl, un, dir);
+
+                if (!m_clip) {
+                    detail::call_with_geometry(func, [this]() {
+                        return make_unclipped_linestring();
+                    }, 0);
+                    return 1;
                 }
 
-                return m_impl.linestring_finish(num_points);
+                const Coordinates* coordinates = m_clipped.data();
+                for (const size_t count : m_parts) {
+                    detail::call_with_geometry(func, [this, coordinates, count]() {
+                        return make_linestring(coordinates, count);
+                    }, 0);
+                    coordinates += count;
+                }
+                return m_parts.size();
             }
 
             linestring_type create_linestring(const osmium::Way& way, use_nodes un=use_nodes::unique, direction dir=direction::forward) {
                 return create_linestring(way.nodes(), un, dir);
             }
 
+            template <class TFunc>
+            size_t create_linestrings(const osmium::Way& way, TFunc&& func, use_nodes un=use_nodes::unique, direction dir=direction::forward) {
+                return create_linestrings(way.nodes(), std::forward<TFunc>(func), un, dir);
+            }
+
             /* MultiPolygon */
 
+            /**
+             * Create a multipolygon. Like for linestrings, the locations
+             * of all rings are projected in one go before anything is
+             * handed to the geometry implementation, unless it projects
+             * them itself.
+             *
+             * If a clip box is set, all rings are clipped to it. Throws
+             * a geometry_error if nothing is left.
+             */
             multipolygon_type create_multipolygon(const osmium::Area& area) {
+                m_locations.clear();
+                m_rings.clear();
+
+                for (auto it = area.cbegin(); it != area.cend(); ++it) {
+                    if (it->type() == osmium::item_type::outer_ring || it->type() == osmium::item_type::inner_ring) {
+                        const osmium::OuterRing& ring = static_cast<const osmium::OuterRing&>(*it);
+                        m_rings.emplace_back(it->type(), add_locations(ring));
+                    }
+                }
+
+                // if there are no rings, this area is invalid
+                if (m_rings.empty()) {
+                    throw geometry_error("invalid area");
+                }
+
+                if (!impl_projects()) {
+                    project_locations();
+                }
+
+                if (m_clip) {
+                    clip_rings();
+                    if (m_rings.empty()) {
+                        throw geometry_error("area outside clip box");
+                    }
+                }
+
                 int num_polygons = 0;
-                int num_rings = 0;
+                size_t offset = 0;
                 m_impl.multipolygon_start();
 
-                for (auto it = area.cbegin(); it != area.cend(); ++it) {
-                    const osmium::OuterRing& ring = static_cast<const osmium::OuterRing&>(*it);
-                    if (it->type() == osmium::item_type::outer_ring) {
+                for (const auto& ring : m_rings) {
+                    if (ring.first == osmium::item_type::outer_ring) {
                         if (num_polygons > 0) {
                             m_impl.multipolygon_polygon_finish();
                         }
                         m_impl.multipolygon_polygon_start();
                         m_impl.multipolygon_outer_ring_start();
-                        add_points(ring);
+                        add_points(offset, ring.second);
                         m_impl.multipolygon_outer_ring_finish();
-                        ++num_rings;
                         ++num_polygons;
-                    } else if (it->type() == osmium::item_type::inner_ring) {
+                    } else {
                         m_impl.multipolygon_inner_ring_start();
-                        add_points(ring);
+                        add_points(offset, ring.second);
                         m_impl.multipolygon_inner_ring_finish();
-                        ++num_rings;
                     }
-                }
-
-                // if there are no rings, this area is invalid
-                if (num_rings == 0) {
-                    throw geometry_error("invalid area");
+                    offset += ring.second;
                 }
 
                 m_impl.multipolygon_polygon_finish();
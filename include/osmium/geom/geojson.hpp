@@ -46,93 +46,97 @@ namespace osmium {
 
         namespace detail {
 
+            template <class TOutput = StringOutput>
             class GeoJSONFactoryImpl {
 
-                std::string m_str {};
+                TOutput m_out;
 
             public:
 
-                typedef std::string point_type;
-                typedef std::string linestring_type;
-                typedef std::string polygon_type;
-                typedef std::string multipolygon_type;
-                typedef std::string ring_type;
+                typedef typename TOutput::result_type point_type;
+                typedef typename TOutput::result_type linestring_type;
+                typedef typename TOutput::result_type polygon_type;
+                typedef typename TOutput::result_type multipolygon_type;
+                typedef typename TOutput::result_type ring_type;
 
                 GeoJSONFactoryImpl() = default;
 
+                explicit GeoJSONFactoryImpl(std::string& out) :
+                    m_out(out) {
+                }
+
                 /* Point */
 
                 // { "type": "Point", "coordinates": [100.0, 0.0] }
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
-                    std::string str {"{\"type\":\"Point\",\"coordinates\":"};
-                    xy.append_to_string(str, '[', ',', ']');
-                    str += "}";
-                    return str;
+                    return m_out.write([&xy](std::string& str) {
+                        str += "{\"type\":\"Point\",\"coordinates\":";
+                        xy.append_to_string(str, '[', ',', ']');
+                        str += "}";
+                    });
                 }
 
                 /* LineString */
 
                 // { "type": "LineString", "coordinates": [ [100.0, 0.0], [101.0, 1.0] ] }
                 void linestring_start() {
-                    m_str = "{\"type\":\"LineString\",\"coordinates\":[";
+                    m_out.start() += "{\"type\":\"LineString\",\"coordinates\":[";
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, '[', ',', ']');
-                    m_str += ',';
+                    xy.append_to_string(m_out.str(), '[', ',', ']');
+                    m_out.str() += ',';
                 }
 
                 linestring_type linestring_finish(int /* num_points */) {
-                    assert(!m_str.empty());
-                    std::string str;
-                    std::swap(str, m_str);
-                    str.back() = ']';
-                    str += "}";
-                    return str;
+                    assert(!m_out.str().empty());
+                    m_out.str().back() = ']';
+                    m_out.str() += "}";
+                    return m_out.finish();
                 }
 
                 /* MultiPolygon */
 
                 void multipolygon_start() {
-                    m_str = "{\"type\":\"MultiPolygon\",\"coordinates\":[";
+                    m_out.start() += "{\"type\":\"MultiPolygon\",\"coordinates\":[";
                 }
 
                 void multipolygon_polygon_start() {
-                    m_str += '[';
+                    m_out.str() += '[';
                 }
 
                 void multipolygon_polygon_finish() {
-                    m_str += "],";
+                    m_out.str() += "],";
                 }
 
                 void multipolygon_outer_ring_start() {
-                    m_str += '[';
+                    m_out.str() += '[';
                 }
 
                 void multipolygon_outer_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ']';
+                    assert(!m_out.str().empty());
+                    m_out.str().back() = ']';
                 }
 
                 void multipolygon_inner_ring_start() {
-                    m_str += ",[";
+                    m_out.str() += ",[";
                 }
 
                 void multipolygon_inner_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ']';
+                    assert(!m_out.str().empty());
+                    m_out.str().back() = ']';
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, '[', ',', ']');
-                    m_str += ',';
+                    xy.append_to_string(m_out.str(), '[', ',', ']');
+                    m_out.str() += ',';
                 }
 
                 multipolygon_type multipolygon_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ']';
-                    m_str += "}";
-                    return std::move(m_str);
+                    assert(!m_out.str().empty());
+                    m_out.str().back() = ']';
+                    m_out.str() += "}";
+                    return m_out.finish();
                 }
 
             }; // class GeoJSONFactoryImpl
@@ -140,7 +144,14 @@ namespace osmium {
         } // namespace detail
 
         template <class TProjection = IdentityProjection>
-        using GeoJSONFactory = GeometryFactory<osmium::geom::detail::GeoJSONFactoryImpl, TProjection>;
+        using GeoJSONFactory = GeometryFactory<osmium::geom::detail::GeoJSONFactoryImpl<>, TProjection>;
+
+        /**
+         * GeoJSON factory appending the geometries to a string given to
+         * the constructor instead of returning them.
+         */
+        template <class TProjection = IdentityProjection>
+        using GeoJSONAppendFactory = GeometryFactory<osmium::geom::detail::GeoJSONFactoryImpl<osmium::geom::detail::AppendOutput>, TProjection>;
 
     } // namespace geom
 
@@ -36,7 +36,13 @@ DEALINGS IN THE SOFTWARE.
 #define OSMIUM_COMPILE_WITH_CFLAGS_GEOS `geos-config --cflags`
 #define OSMIUM_LINK_WITH_LIBS_GEOS `geos-config --libs`
 
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <iterator>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include <geos/geom/Coordinate.h>
 #include <geos/geom/CoordinateSequence.h>
@@ -47,10 +53,13 @@ DEALINGS IN THE SOFTWARE.
 #include <geos/geom/Point.h>
 #include <geos/geom/Polygon.h>
 #include <geos/geom/PrecisionModel.h>
+#include <geos/geom/prep/PreparedGeometry.h>
+#include <geos/geom/prep/PreparedGeometryFactory.h>
 #include <geos/util/GEOSException.h>
 
 #include <osmium/geom/factory.hpp>
 #include <osmium/geom/coordinates.hpp>
+#include <osmium/osm/location.hpp>
 
 namespace osmium {
 
@@ -69,12 +78,74 @@ namespace osmium {
             class GEOSFactoryImpl {
 
                 geos::geom::PrecisionModel m_precision_model;
-                geos::geom::GeometryFactory m_geos_factory;
 
-                std::unique_ptr<geos::geom::CoordinateSequence> m_coordinate_sequence;
+                // GEOS geometry factory, only set if we created it ourselves
+                std::unique_ptr<geos::geom::GeometryFactory> m_own_geos_factory;
+
+                const geos::geom::GeometryFactory* m_geos_factory;
+
+                // Coordinates of the linestring or ring currently being
+                // built. Ownership is handed to GEOS when it is finished.
+                std::unique_ptr<std::vector<geos::geom::Coordinate>> m_coordinates;
+
                 std::vector<std::unique_ptr<geos::geom::LinearRing>> m_rings;
                 std::vector<std::unique_ptr<geos::geom::Polygon>> m_polygons;
 
+                // Number of locations projected at once when projecting
+                // straight into m_coordinates.
+                static constexpr size_t projection_chunk_size = 64;
+
+                void coordinates_start() {
+                    m_coordinates.reset(new std::vector<geos::geom::Coordinate>());
+                }
+
+                void coordinates_add(const osmium::geom::Coordinates& xy) {
+                    m_coordinates->emplace_back(xy.x, xy.y);
+                }
+
+                void coordinates_add(const osmium::geom::Coordinates* coordinates, size_t count) {
+                    // Usually all coordinates come in one batch. Only
+                    // reserve for that, so adding more batches or single
+                    // coordinates later keeps the geometric growth of the
+                    // vector.
+                    if (m_coordinates->empty()) {
+                        m_coordinates->reserve(count);
+                    }
+                    for (size_t i = 0; i < count; ++i) {
+                        m_coordinates->emplace_back(coordinates[i].x, coordinates[i].y);
+                    }
+                }
+
+                /**
+                 * Project the locations straight into the coordinates
+                 * handed to GEOS. They are projected in small chunks, so
+                 * projections with a batch interface can still use it.
+                 */
+                template <class TProjection>
+                void coordinates_add(const osmium::Location* locations, size_t count, const TProjection& projection) {
+                    if (m_coordinates->empty()) {
+                        m_coordinates->reserve(count);
+                    }
+                    osmium::geom::Coordinates chunk[projection_chunk_size];
+                    while (count > 0) {
+                        const size_t n = count < projection_chunk_size ? count : projection_chunk_size;
+                        osmium::geom::detail::project(projection, locations, chunk, n, 0);
+                        for (size_t i = 0; i < n; ++i) {
+                            m_coordinates->emplace_back(chunk[i].x, chunk[i].y);
+                        }
+                        locations += n;
+                        count -= n;
+                    }
+                }
+
+                /**
+                 * Create a coordinate sequence from the collected
+                 * coordinates without copying them.
+                 */
+                geos::geom::CoordinateSequence* coordinates_finish() {
+                    return m_geos_factory->getCoordinateSequenceFactory()->create(m_coordinates.release(), 2);
+                }
+
             public:
 
                 typedef std::unique_ptr<geos::geom::Point>        point_type;
@@ -85,14 +156,32 @@ namespace osmium {
 
                 explicit GEOSFactoryImpl(int srid = -1) :
                     m_precision_model(),
-                    m_geos_factory(&m_precision_model, srid) {
+                    m_own_geos_factory(new geos::geom::GeometryFactory(&m_precision_model, srid)),
+                    m_geos_factory(m_own_geos_factory.get()),
+                    m_coordinates(),
+                    m_rings(),
+                    m_polygons() {
+                }
+
+                /**
+                 * Use an existing GEOS geometry factory, so all geometries
+                 * share its precision model and SRID. The factory must
+                 * outlive this object and all geometries created with it.
+                 */
+                explicit GEOSFactoryImpl(const geos::geom::GeometryFactory& geos_factory) :
+                    m_precision_model(),
+                    m_own_geos_factory(),
+                    m_geos_factory(&geos_factory),
+                    m_coordinates(),
+                    m_rings(),
+                    m_polygons() {
                 }
 
                 /* Point */
 
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
                     try {
-                        return point_type(m_geos_factory.createPoint(geos::geom::Coordinate(xy.x, xy.y)));
+                        return point_type(m_geos_factory->createPoint(geos::geom::Coordinate(xy.x, xy.y)));
                     } catch (geos::util::GEOSException& e) {
                         std::throw_with_nested(osmium::geos_geometry_error());
                     }
@@ -101,24 +190,25 @@ namespace osmium {
                 /* LineString */
 
                 void linestring_start() {
-                    try {
-                        m_coordinate_sequence.reset(m_geos_factory.getCoordinateSequenceFactory()->create(static_cast<size_t>(0), 2));
-                    } catch (geos::util::GEOSException& e) {
-                        std::throw_with_nested(osmium::geos_geometry_error());
-                    }
+                    coordinates_start();
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    try {
-                        m_coordinate_sequence->add(geos::geom::Coordinate(xy.x, xy.y));
-                    } catch (geos::util::GEOSException& e) {
-                        std::throw_with_nested(osmium::geos_geometry_error());
-                    }
+                    coordinates_add(xy);
+                }
+
+                void linestring_add_locations(const osmium::geom::Coordinates* coordinates, size_t count) {
+                    coordinates_add(coordinates, count);
+                }
+
+                template <class TProjection>
+                void linestring_add_locations(const osmium::Location* locations, size_t count, const TProjection& projection) {
+                    coordinates_add(locations, count, projection);
                 }
 
                 linestring_type linestring_finish(int /* num_points */) {
                     try {
-                        return linestring_type(m_geos_factory.createLineString(m_coordinate_sequence.release()));
+                        return linestring_type(m_geos_factory->createLineString(coordinates_finish()));
                     } catch (geos::util::GEOSException& e) {
                         std::throw_with_nested(osmium::geos_geometry_error());
                     }
@@ -141,7 +231,7 @@ namespace osmium {
                         std::transform(std::next(m_rings.begin(), 1), m_rings.end(), std::back_inserter(*inner_rings), [](std::unique_ptr<geos::geom::LinearRing>& r) {
                             return r.release();
                         });
-                        m_polygons.emplace_back(m_geos_factory.createPolygon(m_rings[0].release(), inner_rings));
+                        m_polygons.emplace_back(m_geos_factory->createPolygon(m_rings[0].release(), inner_rings));
                         m_rings.clear();
                     } catch (geos::util::GEOSException& e) {
                         std::throw_with_nested(osmium::geos_geometry_error());
@@ -149,43 +239,40 @@ namespace osmium {
                 }
 
                 void multipolygon_outer_ring_start() {
-                    try {
-                        m_coordinate_sequence.reset(m_geos_factory.getCoordinateSequenceFactory()->create(static_cast<size_t>(0), 2));
-                    } catch (geos::util::GEOSException& e) {
-                        std::throw_with_nested(osmium::geos_geometry_error());
-                    }
+                    coordinates_start();
                 }
 
                 void multipolygon_outer_ring_finish() {
                     try {
-                        m_rings.emplace_back(m_geos_factory.createLinearRing(m_coordinate_sequence.release()));
+                        m_rings.emplace_back(m_geos_factory->createLinearRing(coordinates_finish()));
                     } catch (geos::util::GEOSException& e) {
                         std::throw_with_nested(osmium::geos_geometry_error());
                     }
                 }
 
                 void multipolygon_inner_ring_start() {
-                    try {
-                        m_coordinate_sequence.reset(m_geos_factory.getCoordinateSequenceFactory()->create(static_cast<size_t>(0), 2));
-                    } catch (geos::util::GEOSException& e) {
-                        std::throw_with_nested(osmium::geos_geometry_error());
-                    }
+                    coordinates_start();
                 }
 
                 void multipolygon_inner_ring_finish() {
                     try {
-                        m_rings.emplace_back(m_geos_factory.createLinearRing(m_coordinate_sequence.release()));
+                        m_rings.emplace_back(m_geos_factory->createLinearRing(coordinates_finish()));
                     } catch (geos::util::GEOSException& e) {
                         std::throw_with_nested(osmium::geos_geometry_error());
                     }
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    try {
-                        m_coordinate_sequence->add(geos::geom::Coordinate(xy.x, xy.y));
-                    } catch (geos::util::GEOSException& e) {
-                        std::throw_with_nested(osmium::geos_geometry_error());
-                    }
+                    coordinates_add(xy);
+                }
+
+                void multipolygon_add_locations(const osmium::geom::Coordinates* coordinates, size_t count) {
+                    coordinates_add(coordinates, count);
+                }
+
+                template <class TProjection>
+                void multipolygon_add_locations(const osmium::Location* locations, size_t count, const TProjection& projection) {
+                    coordinates_add(locations, count, projection);
                 }
 
                 multipolygon_type multipolygon_finish() {
@@ -195,7 +282,7 @@ namespace osmium {
                             return p.release();
                         });
                         m_polygons.clear();
-                        return multipolygon_type(m_geos_factory.createMultiPolygon(polygons));
+                        return multipolygon_type(m_geos_factory->createMultiPolygon(polygons));
                     } catch (geos::util::GEOSException& e) {
                         std::throw_with_nested(osmium::geos_geometry_error());
                     }
@@ -208,6 +295,67 @@ namespace osmium {
         template <class TProjection = IdentityProjection>
         using GEOSFactory = GeometryFactory<osmium::geom::detail::GEOSFactoryImpl, TProjection>;
 
+        /**
+         * A GEOS geometry together with its prepared version. Use this
+         * for repeated predicate tests against the same geometry, for
+         * instance to check which of many points are inside an area.
+         */
+        class GEOSPreparedGeometry {
+
+            std::unique_ptr<geos::geom::Geometry> m_geometry;
+            std::unique_ptr<const geos::geom::prep::PreparedGeometry> m_prepared;
+
+        public:
+
+            /**
+             * Prepare a geometry. It is moved into this object, so it
+             * lives as long as the prepared geometry needs it.
+             */
+            template <class TGeometry>
+            explicit GEOSPreparedGeometry(std::unique_ptr<TGeometry>&& geometry) :
+                m_geometry(std::move(geometry)),
+                m_prepared() {
+                try {
+                    m_prepared.reset(geos::geom::prep::PreparedGeometryFactory::prepare(m_geometry.get()));
+                } catch (geos::util::GEOSException& e) {
+                    std::throw_with_nested(osmium::geos_geometry_error());
+                }
+            }
+
+            const geos::geom::Geometry& geometry() const {
+                return *m_geometry;
+            }
+
+            const geos::geom::prep::PreparedGeometry& prepared() const {
+                return *m_prepared;
+            }
+
+            bool contains(const geos::geom::Geometry& other) const {
+                try {
+                    return m_prepared->contains(&other);
+                } catch (geos::util::GEOSException& e) {
+                    std::throw_with_nested(osmium::geos_geometry_error());
+                }
+            }
+
+            bool covers(const geos::geom::Geometry& other) const {
+                try {
+                    return m_prepared->covers(&other);
+                } catch (geos::util::GEOSException& e) {
+                    std::throw_with_nested(osmium::geos_geometry_error());
+                }
+            }
+
+            bool intersects(const geos::geom::Geometry& other) const {
+                try {
+                    return m_prepared->intersects(&other);
+                } catch (geos::util::GEOSException& e) {
+                    std::throw_with_nested(osmium::geos_geometry_error());
+                }
+            }
+
+        }; // class GEOSPreparedGeometry
+
     } // namespace geom
 
 } // namespace osmium
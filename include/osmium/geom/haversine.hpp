@@ -33,11 +33,17 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <vector>
 
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/geom/util.hpp>
+#include <osmium/memory/buffer.hpp>
 #include <osmium/memory/collection.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
@@ -87,6 +93,289 @@ namespace osmium {
                 return sum_length;
             }
 
+            namespace detail {
+
+                /**
+                 * Segments with a larger difference in longitude or
+                 * latitude (in degrees) than this are calculated with
+                 * distance(), because the polynomials used for the batch
+                 * calculation are only exact for small angles.
+                 */
+                constexpr double MAX_BATCH_DELTA = 10.0;
+
+                /**
+                 * Sine of x for angles up to half of MAX_BATCH_DELTA
+                 * from its Taylor series. Like the other
+                 * functions in this namespace this uses no branches and
+                 * no function calls, so the compiler can vectorize loops
+                 * using it.
+                 */
+                inline double sin_small(double x) noexcept {
+                    const double x2 = x * x;
+                    double s = 1.0 / 362880.0;
+                    s = s * x2 - 1.0 / 5040.0;
+                    s = s * x2 + 1.0 / 120.0;
+                    s = s * x2 - 1.0 / 6.0;
+                    return (s * x2 + 1.0) * x;
+                }
+
+                /**
+                 * Cosine of x for -PI/2 <= x <= PI/2 from its Taylor
+                 * series.
+                 */
+                inline double cos(double x) noexcept {
+                    const double x2 = x * x;
+                    double c = 1.0 / 2432902008176640000.0;
+                    c = c * x2 - 1.0 / 6402373705728000.0;
+                    c = c * x2 + 1.0 / 20922789888000.0;
+                    c = c * x2 - 1.0 / 87178291200.0;
+                    c = c * x2 + 1.0 / 479001600.0;
+                    c = c * x2 - 1.0 / 3628800.0;
+                    c = c * x2 + 1.0 / 40320.0;
+                    c = c * x2 - 1.0 / 720.0;
+                    c = c * x2 + 1.0 / 24.0;
+                    c = c * x2 - 1.0 / 2.0;
+                    return c * x2 + 1.0;
+                }
+
+                /**
+                 * Square root of a non-negative number. std::sqrt() can
+                 * set errno, which keeps the compiler from vectorizing
+                 * loops using it, so this refines an estimate of
+                 * 1/sqrt(x) from the bits of x with Newton's method.
+                 */
+                inline double sqrt(double x) noexcept {
+                    uint64_t bits;
+                    std::memcpy(&bits, &x, sizeof(bits));
+                    bits = 0x5fe6eb50c7b537a9ULL - (bits >> 1);
+                    double y;
+                    std::memcpy(&y, &bits, sizeof(y));
+                    const double half_x = x * 0.5;
+                    y = y * (1.5 - half_x * y * y);
+                    y = y * (1.5 - half_x * y * y);
+                    y = y * (1.5 - half_x * y * y);
+                    y = y * (1.5 - half_x * y * y);
+                    return x * y;
+                }
+
+                /**
+                 * Arc sine of x for 0 <= x <= 0.125 from its Taylor
+                 * series. This covers segments within MAX_BATCH_DELTA.
+                 */
+                inline double asin_small(double x) noexcept {
+                    const double x2 = x * x;
+                    double a = 6435.0 / 557056.0;
+                    a = a * x2 + 143.0 / 10240.0;
+                    a = a * x2 + 231.0 / 13312.0;
+                    a = a * x2 + 63.0 / 2816.0;
+                    a = a * x2 + 35.0 / 1152.0;
+                    a = a * x2 + 5.0 / 112.0;
+                    a = a * x2 + 3.0 / 40.0;
+                    a = a * x2 + 1.0 / 6.0;
+                    return (a * x2 + 1.0) * x;
+                }
+
+                /**
+                 * Haversine distance in meters between two points given
+                 * as longitude and latitude in degrees together with the
+                 * cosines of their latitudes. Only valid if the points
+                 * are within MAX_BATCH_DELTA of each other. Like in
+                 * distance() the differences are calculated before
+                 * converting to radians, which keeps short segments exact.
+                 */
+                inline double distance(double lon1, double lat1, double cos_lat1, double lon2, double lat2, double cos_lat2) noexcept {
+                    double lonh = sin_small(deg_to_rad(lon1 - lon2) * 0.5);
+                    lonh *= lonh;
+                    double lath = sin_small(deg_to_rad(lat1 - lat2) * 0.5);
+                    lath *= lath;
+                    return 2.0 * EARTH_RADIUS_IN_METERS * asin_small(detail::sqrt(lath + cos_lat1 * cos_lat2 * lonh));
+                }
+
+                /**
+                 * Distance in meters between two points using the
+                 * equirectangular approximation: The segment is treated
+                 * as a straight line on a plane where longitudes are
+                 * scaled by the mean of the cosines of both latitudes.
+                 */
+                inline double equirectangular_distance(double lon1, double lat1, double cos_lat1, double lon2, double lat2, double cos_lat2) noexcept {
+                    double dlon = std::abs(lon1 - lon2);
+                    dlon = std::min(dlon, 360.0 - dlon);
+                    const double x = deg_to_rad(dlon) * (cos_lat1 + cos_lat2) * 0.5;
+                    const double y = deg_to_rad(lat1 - lat2);
+                    return EARTH_RADIUS_IN_METERS * detail::sqrt(x * x + y * y);
+                }
+
+            } // namespace detail
+
+            /**
+             * Formula used by WayLengthCalculator.
+             */
+            enum class method {
+
+                /**
+                 * Haversine formula. Segments spanning less than 10
+                 * degrees are calculated with polynomial approximations
+                 * of the trigonometric functions, longer ones with
+                 * distance(). The relative error of a segment length
+                 * is below 1e-13 in both cases.
+                 */
+                haversine,
+
+                /**
+                 * Equirectangular approximation. Faster, but only usable
+                 * for short segments. For segments between latitudes
+                 * -80 and 80 the relative error is below 1e-7 up to a
+                 * length of 1 km, below 1e-5 up to 10 km and below 1e-3
+                 * up to 100 km. Closer to the poles the error is up to
+                 * 100 times larger.
+                 */
+                equirectangular
+
+            }; // enum class method
+
+            /**
+             * Calculates the lengths of many ways at once. The locations
+             * of all ways are collected in arrays first, then the cosine
+             * of the latitude is calculated once for each node and the
+             * length of all segments in one loop. These loops use no
+             * branches and no function calls, so the compiler can
+             * vectorize them. The few segments spanning more than
+             * detail::MAX_BATCH_DELTA degrees are calculated again
+             * afterwards. The arrays are kept between calls to save on
+             * allocations.
+             */
+            class WayLengthCalculator {
+
+                method m_method;
+
+                // locations of all nodes of all ways
+                std::vector<osmium::Location> m_locations {};
+
+                // longitudes and latitudes in degrees and cosines of
+                // latitudes of all nodes of all ways
+                std::vector<double> m_lon {};
+                std::vector<double> m_lat {};
+                std::vector<double> m_cos_lat {};
+
+                // length of the segment from node i to node i+1, this is
+                // not meaningful if the nodes belong to different ways
+                std::vector<double> m_segment_length {};
+
+                void clear() {
+                    m_locations.clear();
+                }
+
+                void add_locations(const osmium::WayNodeList& wnl) {
+                    for (const osmium::NodeRef& node_ref : wnl) {
+                        const osmium::Location location = node_ref.location();
+                        if (!location.valid()) {
+                            throw osmium::invalid_location("invalid location");
+                        }
+                        m_locations.push_back(location);
+                    }
+                }
+
+                void calculate() {
+                    const size_t count = m_locations.size();
+                    if (count < 2) {
+                        return;
+                    }
+
+                    m_lon.resize(count);
+                    m_lat.resize(count);
+                    m_cos_lat.resize(count);
+                    const osmium::Location* locations = m_locations.data();
+                    double* lon = m_lon.data();
+                    double* lat = m_lat.data();
+                    double* cos_lat = m_cos_lat.data();
+                    for (size_t i = 0; i < count; ++i) {
+                        lon[i] = osmium::Location::fix_to_double(locations[i].x());
+                        lat[i] = osmium::Location::fix_to_double(locations[i].y());
+                        cos_lat[i] = detail::cos(deg_to_rad(lat[i]));
+                    }
+
+                    m_segment_length.resize(count - 1);
+                    double* length = m_segment_length.data();
+                    if (m_method == method::haversine) {
+                        for (size_t i = 0; i < count - 1; ++i) {
+                            length[i] = detail::distance(lon[i], lat[i], cos_lat[i], lon[i + 1], lat[i + 1], cos_lat[i + 1]);
+                        }
+
+                        // long segments are rare, calculate them again
+                        for (size_t i = 0; i < count - 1; ++i) {
+                            if (std::abs(lon[i] - lon[i + 1]) > detail::MAX_BATCH_DELTA ||
+                                std::abs(lat[i] - lat[i + 1]) > detail::MAX_BATCH_DELTA) {
+                                length[i] = distance(Coordinates{lon[i], lat[i]}, Coordinates{lon[i + 1], lat[i + 1]});
+                            }
+                        }
+                    } else {
+                        for (size_t i = 0; i < count - 1; ++i) {
+                            length[i] = detail::equirectangular_distance(lon[i], lat[i], cos_lat[i], lon[i + 1], lat[i + 1], cos_lat[i + 1]);
+                        }
+                    }
+                }
+
+                /**
+                 * Sum of the lengths of count - 1 segments starting with
+                 * the segment from node first.
+                 */
+                double sum(size_t first, size_t count) const {
+                    double sum_length = 0;
+                    for (size_t i = 1; i < count; ++i) {
+                        sum_length += m_segment_length[first + i - 1];
+                    }
+                    return sum_length;
+                }
+
+            public:
+
+                explicit WayLengthCalculator(method m = method::haversine) :
+                    m_method(m) {
+                }
+
+                /**
+                 * Calculate length of way in meters.
+                 *
+                 * @throws osmium::invalid_location if any of the locations is invalid
+                 */
+                double length(const osmium::WayNodeList& wnl) {
+                    clear();
+                    add_locations(wnl);
+                    calculate();
+                    return sum(0, m_locations.size());
+                }
+
+                double length(const osmium::Way& way) {
+                    return length(way.nodes());
+                }
+
+                /**
+                 * Calculate the lengths in meters of all ways in a buffer
+                 * and call func(way, length) for each of them in the
+                 * order they are in the buffer.
+                 *
+                 * @throws osmium::invalid_location if any of the locations
+                 *         is invalid. This happens before func is called
+                 *         for any way.
+                 */
+                template <class TFunc>
+                void lengths(const osmium::memory::Buffer& buffer, TFunc&& func) {
+                    clear();
+                    for (auto it = buffer.cbegin<osmium::Way>(); it != buffer.cend<osmium::Way>(); ++it) {
+                        add_locations(it->nodes());
+                    }
+                    calculate();
+
+                    size_t first = 0;
+                    for (auto it = buffer.cbegin<osmium::Way>(); it != buffer.cend<osmium::Way>(); ++it) {
+                        const size_t count = it->nodes().size();
+                        func(*it, sum(first, count));
+                        first += count;
+                    }
+                }
+
+            }; // class WayLengthCalculator
+
         } // namespace haversine
 
     } // namespace geom
@@ -34,6 +34,9 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
 
 #include <osmium/geom/coordinates.hpp>
@@ -44,6 +47,12 @@ namespace osmium {
 
     namespace geom {
 
+        /**
+         * The maximum latitude that can be projected with the Web Mercator
+         * (EPSG:3857) projection.
+         */
+        constexpr double MERCATOR_MAX_LAT = 85.0511288;
+
         namespace detail {
 
             constexpr double EARTH_RADIUS_FOR_EPSG3857 = 6378137.0;
@@ -52,8 +61,93 @@ namespace osmium {
                 return EARTH_RADIUS_FOR_EPSG3857 * deg_to_rad(lon);
             }
 
+            /**
+             * Natural logarithm of a positive, finite number. Unlike
+             * std::log() this has no branches and no function calls, so
+             * the compiler can vectorize loops using it.
+             */
+            inline double ln(double value) noexcept {
+                // split value * sqrt(2) into exponent and mantissa, so
+                // that value = m * 2^e with sqrt(1/2) <= m < sqrt(2)
+                const double scaled = value * 1.4142135623730951;
+                uint64_t bits;
+                std::memcpy(&bits, &scaled, sizeof(bits));
+
+                // convert exponent to double without an int conversion
+                const uint64_t exponent_bits = (bits >> 52) | 0x4330000000000000ULL;
+                double e;
+                std::memcpy(&e, &exponent_bits, sizeof(e));
+                e -= 4503599627370496.0 + 1023.0;
+
+                bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+                double m;
+                std::memcpy(&m, &bits, sizeof(m));
+                m *= 0.7071067811865476;
+
+                // ln(m) = 2 * atanh(t) with |t| < 0.172
+                const double t = (m - 1.0) / (m + 1.0);
+                const double t2 = t * t;
+                double p = 1.0 / 23;
+                p = p * t2 + 1.0 / 21;
+                p = p * t2 + 1.0 / 19;
+                p = p * t2 + 1.0 / 17;
+                p = p * t2 + 1.0 / 15;
+                p = p * t2 + 1.0 / 13;
+                p = p * t2 + 1.0 / 11;
+                p = p * t2 + 1.0 / 9;
+                p = p * t2 + 1.0 / 7;
+                p = p * t2 + 1.0 / 5;
+                p = p * t2 + 1.0 / 3;
+                p = p * t2 + 1.0;
+
+                // ln(2) split in two parts for more precision
+                return e * 6.93147180369123816490e-01 + (e * 1.90821492927058770002e-10 + 2.0 * t * p);
+            }
+
+            /**
+             * Latitude to y coordinate for latitudes in the range
+             * -MERCATOR_MAX_LAT to MERCATOR_MAX_LAT. This uses
+             * polynomials only, so the compiler can vectorize loops
+             * using it. The result is as exact as the one calculated with
+             * std::log(std::tan(...)).
+             */
+            inline double lat_to_y_in_range(double lat) noexcept {
+                // sine and cosine of half the latitude (|x| < 0.75) from
+                // their Taylor series
+                const double x = deg_to_rad(lat) / 2;
+                const double x2 = x * x;
+
+                double s = -1.0 / 121645100408832000.0;
+                s = s * x2 + 1.0 / 355687428096000.0;
+                s = s * x2 - 1.0 / 1307674368000.0;
+                s = s * x2 + 1.0 / 6227020800.0;
+                s = s * x2 - 1.0 / 39916800.0;
+                s = s * x2 + 1.0 / 362880.0;
+                s = s * x2 - 1.0 / 5040.0;
+                s = s * x2 + 1.0 / 120.0;
+                s = s * x2 - 1.0 / 6.0;
+                s = (s * x2 + 1.0) * x;
+
+                double c = -1.0 / 6402373705728000.0;
+                c = c * x2 + 1.0 / 20922789888000.0;
+                c = c * x2 - 1.0 / 87178291200.0;
+                c = c * x2 + 1.0 / 479001600.0;
+                c = c * x2 - 1.0 / 3628800.0;
+                c = c * x2 + 1.0 / 40320.0;
+                c = c * x2 - 1.0 / 720.0;
+                c = c * x2 + 1.0 / 24.0;
+                c = c * x2 - 1.0 / 2.0;
+                c = c * x2 + 1.0;
+
+                // tan(pi/4 + x) = (cos x + sin x) / (cos x - sin x)
+                return EARTH_RADIUS_FOR_EPSG3857 * ln((c + s) / (c - s));
+            }
+
             inline double lat_to_y(double lat) { // not constexpr because math functions aren't
-                return EARTH_RADIUS_FOR_EPSG3857 * std::log(std::tan(osmium::geom::PI/4 + deg_to_rad(lat)/2));
+                if (lat < -MERCATOR_MAX_LAT || lat > MERCATOR_MAX_LAT) {
+                    return EARTH_RADIUS_FOR_EPSG3857 * std::log(std::tan(osmium::geom::PI/4 + deg_to_rad(lat)/2));
+                }
+                return lat_to_y_in_range(lat);
             }
 
             constexpr inline double x_to_lon(double x) {
@@ -66,12 +160,6 @@ namespace osmium {
 
         } // namespace detail
 
-        /**
-         * The maximum latitude that can be projected with the Web Mercator
-         * (EPSG:3857) projection.
-         */
-        constexpr double MERCATOR_MAX_LAT = 85.0511288;
-
         Coordinates lonlat_to_mercator(const Coordinates& c) {
             return Coordinates(detail::lon_to_x(c.x), detail::lat_to_y(c.y));
         }
@@ -92,6 +180,30 @@ namespace osmium {
                 return Coordinates {detail::lon_to_x(location.lon()), detail::lat_to_y(location.lat())};
             }
 
+            /**
+             * Project count locations at once. The results are the same
+             * as those from operator(), but this is much faster, because
+             * the compiler can vectorize the main loop.
+             *
+             * @throws osmium::invalid_location if any of the locations is invalid
+             */
+            void project(const osmium::Location* locations, Coordinates* coordinates, size_t count) const {
+                for (size_t i = 0; i < count; ++i) {
+                    coordinates[i].x = detail::lon_to_x(locations[i].lon_without_check());
+                    coordinates[i].y = detail::lat_to_y_in_range(locations[i].lat_without_check());
+                }
+
+                for (size_t i = 0; i < count; ++i) {
+                    if (!locations[i].valid()) {
+                        throw osmium::invalid_location("invalid location");
+                    }
+                    const double lat = locations[i].lat_without_check();
+                    if (lat < -MERCATOR_MAX_LAT || lat > MERCATOR_MAX_LAT) {
+                        coordinates[i].y = detail::lat_to_y(lat);
+                    }
+                }
+            }
+
             int epsg() const {
                 return 3857;
             }
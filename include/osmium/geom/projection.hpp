@@ -35,8 +35,14 @@ DEALINGS IN THE SOFTWARE.
 
 #define OSMIUM_LINK_WITH_LIBS_PROJ -lproj
 
+#include <cmath>
+#include <cstddef>
+#include <list>
+#include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
 #include <proj_api.h>
 
@@ -90,7 +96,7 @@ namespace osmium {
              *
              * Coordinates have to be in radians and are produced in radians.
              *
-             * @throws osmmium::projection_error if the projection fails
+             * @throws osmium::projection_error if the projection fails
              */
             friend Coordinates transform(const CRS& src, const CRS& dest, Coordinates c) {
                 int result = pj_transform(src.get(), dest.get(), 1, 1, &c.x, &c.y, nullptr);
@@ -100,6 +106,34 @@ namespace osmium {
                 return c;
             }
 
+            /**
+             * Transform count coordinates in place from one CRS into
+             * another with a single call to the proj library.
+             *
+             * Coordinates have to be in radians and are produced in radians.
+             *
+             * @throws osmium::projection_error if the projection fails for
+             *         any of the coordinates
+             */
+            friend void transform(const CRS& src, const CRS& dest, Coordinates* coordinates, size_t count) {
+                static_assert(sizeof(Coordinates) == 2 * sizeof(double), "Coordinates must consist of exactly two doubles");
+                if (count == 0) {
+                    return;
+                }
+                int result = pj_transform(src.get(), dest.get(), static_cast<long>(count), 2, &coordinates->x, &coordinates->y, nullptr);
+                if (result != 0) {
+                    throw osmium::projection_error(std::string("projection failed: ") + pj_strerrno(result));
+                }
+                // With more than one point, proj doesn't report transient
+                // errors (like coordinates out of range), it sets the
+                // failed points to HUGE_VAL instead.
+                for (size_t i = 0; i < count; ++i) {
+                    if (coordinates[i].x == HUGE_VAL || coordinates[i].y == HUGE_VAL) {
+                        throw osmium::projection_error("projection failed for coordinate " + std::to_string(i));
+                    }
+                }
+            }
+
         }; // class CRS
 
         /**
@@ -140,6 +174,34 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Project count locations at once. This calls the proj library
+             * only once for all of them, which is much faster than calling
+             * operator() for each location.
+             *
+             * @throws osmium::invalid_location if any of the locations is invalid
+             * @throws osmium::projection_error if the projection fails
+             */
+            void project(const osmium::Location* locations, Coordinates* coordinates, size_t count) const {
+                if (m_epsg == 4326) {
+                    for (size_t i = 0; i < count; ++i) {
+                        coordinates[i] = Coordinates(locations[i].lon(), locations[i].lat());
+                    }
+                    return;
+                }
+
+                for (size_t i = 0; i < count; ++i) {
+                    coordinates[i] = Coordinates(deg_to_rad(locations[i].lon()), deg_to_rad(locations[i].lat()));
+                }
+                transform(m_crs_wgs84, m_crs_user, coordinates, count);
+                if (m_crs_user.is_latlong()) {
+                    for (size_t i = 0; i < count; ++i) {
+                        coordinates[i].x = rad_to_deg(coordinates[i].x);
+                        coordinates[i].y = rad_to_deg(coordinates[i].y);
+                    }
+                }
+            }
+
             int epsg() const {
                 return m_epsg;
             }
@@ -150,6 +212,68 @@ namespace osmium {
 
         }; // class Projection
 
+        /**
+         * Cache for Projection objects keyed by EPSG code. Setting up a
+         * projection is expensive, so programs that need many different
+         * ones should get them from here. If more than max_size
+         * projections are in use, the one used least recently is
+         * removed.
+         */
+        class ProjectionCache {
+
+            typedef std::list<std::pair<int, std::shared_ptr<Projection>>> list_type;
+
+            size_t m_max_size;
+
+            // most recently used projection first
+            list_type m_projections {};
+
+            std::map<int, list_type::iterator> m_index {};
+
+        public:
+
+            explicit ProjectionCache(size_t max_size = 16) :
+                m_max_size(max_size) {
+                if (max_size == 0) {
+                    throw std::invalid_argument("ProjectionCache needs room for at least one projection");
+                }
+            }
+
+            /**
+             * Get the projection for the given EPSG code. It is created
+             * if it isn't in the cache.
+             *
+             * @throws osmium::projection_error if the projection can't be created
+             */
+            std::shared_ptr<Projection> get(int epsg) {
+                auto it = m_index.find(epsg);
+                if (it != m_index.end()) {
+                    m_projections.splice(m_projections.begin(), m_projections, it->second);
+                    return it->second->second;
+                }
+
+                std::shared_ptr<Projection> projection = std::make_shared<Projection>(epsg);
+                if (m_projections.size() == m_max_size) {
+                    m_index.erase(m_projections.back().first);
+                    m_projections.pop_back();
+                }
+                m_projections.emplace_front(epsg, projection);
+                m_index[epsg] = m_projections.begin();
+                return projection;
+            }
+
+            /// The number of projections in the cache.
+            size_t size() const {
+                return m_projections.size();
+            }
+
+            void clear() {
+                m_index.clear();
+                m_projections.clear();
+            }
+
+        }; // class ProjectionCache
+
     } // namespace geom
 
 } // namespace osmium
@@ -64,18 +64,50 @@ namespace osmium {
                 std::memcpy(const_cast<char *>(&str[size]), reinterpret_cast<char*>(&data), sizeof(T));
             }
 
-            std::string convert_to_hex(std::string& str) {
-                static const char* lookup_hex = "0123456789ABCDEF";
-                std::string out;
+            template <typename T>
+            inline char* buffer_push(char* buffer, T data) {
+                std::memcpy(buffer, &data, sizeof(T));
+                return buffer + sizeof(T);
+            }
 
-                for (char c : str) {
-                    out += lookup_hex[(c >> 4) & 0xf];
-                    out += lookup_hex[c & 0xf];
+            /**
+             * Append the hex representation of size bytes of data to out.
+             * Looks up both hex digits of each byte at once in a table.
+             */
+            inline void append_hex(std::string& out, const char* data, size_t size) {
+                static const char lookup_hex[] =
+                    "000102030405060708090A0B0C0D0E0F"
+                    "101112131415161718191A1B1C1D1E1F"
+                    "202122232425262728292A2B2C2D2E2F"
+                    "303132333435363738393A3B3C3D3E3F"
+                    "404142434445464748494A4B4C4D4E4F"
+                    "505152535455565758595A5B5C5D5E5F"
+                    "606162636465666768696A6B6C6D6E6F"
+                    "707172737475767778797A7B7C7D7E7F"
+                    "808182838485868788898A8B8C8D8E8F"
+                    "909192939495969798999A9B9C9D9E9F"
+                    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+                    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+                    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+                    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+                    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+                    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+                const size_t offset = out.size();
+                out.resize(offset + 2 * size);
+                char* hex = &out[offset];
+                for (size_t i = 0; i < size; ++i) {
+                    std::memcpy(hex + 2 * i, lookup_hex + 2 * static_cast<unsigned char>(data[i]), 2);
                 }
+            }
 
+            std::string convert_to_hex(std::string& str) {
+                std::string out;
+                append_hex(out, str.data(), str.size());
                 return out;
             }
 
+            template <class TOutput = StringOutput>
             class WKBFactoryImpl {
 
                 /// OSM data always uses SRID 4326 (WGS84).
@@ -109,7 +141,11 @@ namespace osmium {
                     NDR = 1          // Little Endian
                 };
 
+                TOutput m_out;
+
+                // binary WKB of the current geometry if it is written as hex
                 std::string m_data {};
+
                 uint32_t m_points {0};
                 wkb_type m_wkb_type;
                 out_type m_out_type;
@@ -136,19 +172,49 @@ namespace osmium {
                     return offset;
                 }
 
+                /**
+                 * Start a new geometry. Binary WKB is written directly to
+                 * the output, hex WKB is collected in m_data first.
+                 */
+                std::string& start_data() {
+                    if (m_out_type == out_type::hex) {
+                        m_data.clear();
+                        return m_data;
+                    }
+                    return m_out.start();
+                }
+
+                std::string& data() {
+                    return m_out_type == out_type::hex ? m_data : m_out.str();
+                }
+
+                typename TOutput::result_type finish_data() {
+                    if (m_out_type == out_type::hex) {
+                        append_hex(m_out.start(), m_data.data(), m_data.size());
+                    }
+                    return m_out.finish();
+                }
+
                 void set_size(const size_t offset, const uint32_t size) {
-                    memcpy(&m_data[offset], &size, sizeof(uint32_t));
+                    memcpy(&data()[offset], &size, sizeof(uint32_t));
                 }
 
             public:
 
-                typedef std::string point_type;
-                typedef std::string linestring_type;
-                typedef std::string polygon_type;
-                typedef std::string multipolygon_type;
-                typedef std::string ring_type;
+                typedef typename TOutput::result_type point_type;
+                typedef typename TOutput::result_type linestring_type;
+                typedef typename TOutput::result_type polygon_type;
+                typedef typename TOutput::result_type multipolygon_type;
+                typedef typename TOutput::result_type ring_type;
 
                 explicit WKBFactoryImpl(wkb_type wtype=wkb_type::wkb, out_type otype=out_type::binary) :
+                    m_out(),
+                    m_wkb_type(wtype),
+                    m_out_type(otype) {
+                }
+
+                explicit WKBFactoryImpl(std::string& out, wkb_type wtype=wkb_type::wkb, out_type otype=out_type::binary) :
+                    m_out(out),
                     m_wkb_type(wtype),
                     m_out_type(otype) {
                 }
@@ -156,54 +222,54 @@ namespace osmium {
                 /* Point */
 
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
-                    std::string data;
-                    header(data, wkbPoint, false);
-                    str_push(data, xy.x);
-                    str_push(data, xy.y);
-
-                    if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
-                    } else {
-                        return data;
-                    }
+                    return m_out.write([this, &xy](std::string& str) {
+                        // byte order, type, SRID and coordinates
+                        char data[sizeof(uint8_t) + 2 * sizeof(uint32_t) + 2 * sizeof(double)];
+                        char* end = buffer_push(data, wkb_byte_order_type::NDR);
+                        if (m_wkb_type == wkb_type::ewkb) {
+                            end = buffer_push(end, static_cast<uint32_t>(wkbPoint | wkbSRID));
+                            end = buffer_push(end, srid);
+                        } else {
+                            end = buffer_push(end, static_cast<uint32_t>(wkbPoint));
+                        }
+                        end = buffer_push(end, xy.x);
+                        end = buffer_push(end, xy.y);
+
+                        if (m_out_type == out_type::hex) {
+                            append_hex(str, data, static_cast<size_t>(end - data));
+                        } else {
+                            str.append(data, static_cast<size_t>(end - data));
+                        }
+                    });
                 }
 
                 /* LineString */
 
                 void linestring_start() {
-                    m_data.clear();
-                    m_linestring_size_offset = header(m_data, wkbLineString, true);
+                    m_linestring_size_offset = header(start_data(), wkbLineString, true);
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    str_push(m_data, xy.x);
-                    str_push(m_data, xy.y);
+                    str_push(data(), xy.x);
+                    str_push(data(), xy.y);
                 }
 
                 linestring_type linestring_finish(int num_points) {
                     set_size(m_linestring_size_offset, num_points);
-                    std::string data;
-                    std::swap(data, m_data);
-
-                    if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
-                    } else {
-                        return data;
-                    }
+                    return finish_data();
                 }
 
                 /* MultiPolygon */
 
                 void multipolygon_start() {
-                    m_data.clear();
                     m_polygons = 0;
-                    m_multipolygon_size_offset = header(m_data, wkbMultiPolygon, true);
+                    m_multipolygon_size_offset = header(start_data(), wkbMultiPolygon, true);
                 }
 
                 void multipolygon_polygon_start() {
                     ++m_polygons;
                     m_rings = 0;
-                    m_polygon_size_offset = header(m_data, wkbPolygon, true);
+                    m_polygon_size_offset = header(data(), wkbPolygon, true);
                 }
 
                 void multipolygon_polygon_finish() {
@@ -213,8 +279,8 @@ namespace osmium {
                 void multipolygon_outer_ring_start() {
                     ++m_rings;
                     m_points = 0;
-                    m_ring_size_offset = m_data.size();
-                    str_push(m_data, static_cast<uint32_t>(0));
+                    m_ring_size_offset = data().size();
+                    str_push(data(), static_cast<uint32_t>(0));
                 }
 
                 void multipolygon_outer_ring_finish() {
@@ -224,8 +290,8 @@ namespace osmium {
                 void multipolygon_inner_ring_start() {
                     ++m_rings;
                     m_points = 0;
-                    m_ring_size_offset = m_data.size();
-                    str_push(m_data, static_cast<uint32_t>(0));
+                    m_ring_size_offset = data().size();
+                    str_push(data(), static_cast<uint32_t>(0));
                 }
 
                 void multipolygon_inner_ring_finish() {
@@ -233,21 +299,14 @@ namespace osmium {
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    str_push(m_data, xy.x);
-                    str_push(m_data, xy.y);
+                    str_push(data(), xy.x);
+                    str_push(data(), xy.y);
                     ++m_points;
                 }
 
                 multipolygon_type multipolygon_finish() {
                     set_size(m_multipolygon_size_offset, m_polygons);
-                    std::string data;
-                    std::swap(data, m_data);
-
-                    if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
-                    } else {
-                        return data;
-                    }
+                    return finish_data();
                 }
 
             }; // class WKBFactoryImpl
@@ -255,7 +314,14 @@ namespace osmium {
         } // namespace detail
 
         template <class TProjection = IdentityProjection>
-        using WKBFactory = GeometryFactory<osmium::geom::detail::WKBFactoryImpl, TProjection>;
+        using WKBFactory = GeometryFactory<osmium::geom::detail::WKBFactoryImpl<>, TProjection>;
+
+        /**
+         * WKB factory appending the geometries to a string given to the
+         * constructor instead of returning them.
+         */
+        template <class TProjection = IdentityProjection>
+        using WKBAppendFactory = GeometryFactory<osmium::geom::detail::WKBFactoryImpl<osmium::geom::detail::AppendOutput>, TProjection>;
 
     } // namespace geom
 
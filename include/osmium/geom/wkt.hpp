@@ -46,86 +46,92 @@ namespace osmium {
 
         namespace detail {
 
+            template <class TOutput = StringOutput>
             class WKTFactoryImpl {
 
-                std::string m_str {};
+                TOutput m_out;
 
             public:
 
-                typedef std::string point_type;
-                typedef std::string linestring_type;
-                typedef std::string polygon_type;
-                typedef std::string multipolygon_type;
-                typedef std::string ring_type;
+                typedef typename TOutput::result_type point_type;
+                typedef typename TOutput::result_type linestring_type;
+                typedef typename TOutput::result_type polygon_type;
+                typedef typename TOutput::result_type multipolygon_type;
+                typedef typename TOutput::result_type ring_type;
+
+                WKTFactoryImpl() = default;
+
+                explicit WKTFactoryImpl(std::string& out) :
+                    m_out(out) {
+                }
 
                 /* Point */
 
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
-                    std::string str {"POINT"};
-                    xy.append_to_string(str, '(', ' ', ')');
-                    return str;
+                    return m_out.write([&xy](std::string& str) {
+                        str += "POINT";
+                        xy.append_to_string(str, '(', ' ', ')');
+                    });
                 }
 
                 /* LineString */
 
                 void linestring_start() {
-                    m_str = "LINESTRING(";
+                    m_out.start() += "LINESTRING(";
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, ' ');
-                    m_str += ',';
+                    xy.append_to_string(m_out.str(), ' ');
+                    m_out.str() += ',';
                 }
 
                 linestring_type linestring_finish(int /* num_points */) {
-                    assert(!m_str.empty());
-                    std::string str;
-                    std::swap(str, m_str);
-                    str.back() = ')';
-                    return str;
+                    assert(!m_out.str().empty());
+                    m_out.str().back() = ')';
+                    return m_out.finish();
                 }
 
                 /* MultiPolygon */
 
                 void multipolygon_start() {
-                    m_str = "MULTIPOLYGON(";
+                    m_out.start() += "MULTIPOLYGON(";
                 }
 
                 void multipolygon_polygon_start() {
-                    m_str += '(';
+                    m_out.str() += '(';
                 }
 
                 void multipolygon_polygon_finish() {
-                    m_str += "),";
+                    m_out.str() += "),";
                 }
 
                 void multipolygon_outer_ring_start() {
-                    m_str += '(';
+                    m_out.str() += '(';
                 }
 
                 void multipolygon_outer_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ')';
+                    assert(!m_out.str().empty());
+                    m_out.str().back() = ')';
                 }
 
                 void multipolygon_inner_ring_start() {
-                    m_str += ",(";
+                    m_out.str() += ",(";
                 }
 
                 void multipolygon_inner_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ')';
+                    assert(!m_out.str().empty());
+                    m_out.str().back() = ')';
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, ' ');
-                    m_str += ',';
+                    xy.append_to_string(m_out.str(), ' ');
+                    m_out.str() += ',';
                 }
 
                 multipolygon_type multipolygon_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ')';
-                    return std::move(m_str);
+                    assert(!m_out.str().empty());
+                    m_out.str().back() = ')';
+                    return m_out.finish();
                 }
 
             }; // class WKTFactoryImpl
@@ -133,7 +139,14 @@ namespace osmium {
         } // namespace detail
 
         template <class TProjection = IdentityProjection>
-        using WKTFactory = GeometryFactory<osmium::geom::detail::WKTFactoryImpl, TProjection>;
+        using WKTFactory = GeometryFactory<osmium::geom::detail::WKTFactoryImpl<>, TProjection>;
+
+        /**
+         * WKT factory appending the geometries to a string given to the
+         * constructor instead of returning them.
+         */
+        template <class TProjection = IdentityProjection>
+        using WKTAppendFactory = GeometryFactory<osmium::geom::detail::WKTFactoryImpl<osmium::geom::detail::AppendOutput>, TProjection>;
 
     } // namespace geom
 
@@ -33,9 +33,14 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <atomic>
+#include <utility>
+#include <vector>
+
 #include <osmium/handler.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map/dummy.hpp>
+#include <osmium/memory/buffer.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
@@ -67,7 +72,7 @@ namespace osmium {
 
             bool m_ignore_errors {false};
 
-            bool m_must_sort {false};
+            std::atomic<bool> m_must_sort {false};
 
             // It is okay to have this static dummy instance, even when using several threads,
             // because it is read-only.
@@ -106,6 +111,37 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Store the locations of all nodes in the buffer in the storage.
+             *
+             * This can be called from several threads at the same time,
+             * each with a different buffer, so that node buffers can be
+             * indexed by pool workers while the reader keeps decoding.
+             * The storage classes must support set_concurrently() for
+             * this (see VectorBasedDenseMap). Wait for all those calls
+             * to finish before calling way().
+             */
+            void node_buffer(const osmium::memory::Buffer& buffer) {
+                typedef std::pair<osmium::unsigned_object_id_type, osmium::Location> id_location_type;
+                std::vector<id_location_type> pos;
+                std::vector<id_location_type> neg;
+
+                for (auto it = buffer.cbegin<osmium::Node>(); it != buffer.cend<osmium::Node>(); ++it) {
+                    const osmium::object_id_type id = it->id();
+                    if (id >= 0) {
+                        pos.emplace_back(id, it->location());
+                    } else {
+                        neg.emplace_back(-id, it->location());
+                    }
+                }
+
+                if (!pos.empty() || !neg.empty()) {
+                    m_must_sort = true;
+                }
+                m_storage_pos.set_concurrently(pos.cbegin(), pos.cend());
+                m_storage_neg.set_concurrently(neg.cbegin(), neg.cend());
+            }
+
             /**
              * Get location of node with given id.
              */
@@ -114,15 +150,26 @@ namespace osmium {
             }
 
             /**
-             * Retrieve locations of all nodes in the way from storage and add
-             * them to the way object.
+             * Sort the storage if any nodes were added since the last
+             * lookup. This is done automatically by way(), but must be
+             * called explicitly before using way_locations().
              */
-            void way(osmium::Way& way) {
+            void prepare_for_lookup() {
                 if (m_must_sort) {
                     m_storage_pos.sort();
                     m_storage_neg.sort();
                     m_must_sort = false;
                 }
+            }
+
+            /**
+             * Retrieve locations of all nodes in the way from storage and add
+             * them to the way object. This does not change the handler or
+             * the storage, so it can be called from several threads at the
+             * same time, but prepare_for_lookup() must have been called
+             * after the last node was stored.
+             */
+            void way_locations(osmium::Way& way) const {
                 bool error = false;
                 for (auto& node_ref : way.nodes()) {
                     try {
@@ -139,6 +186,15 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Retrieve locations of all nodes in the way from storage and add
+             * them to the way object.
+             */
+            void way(osmium::Way& way) {
+                prepare_for_lookup();
+                way_locations(way);
+            }
+
         }; // class NodeLocationsForWays
 
     } // namespace handler
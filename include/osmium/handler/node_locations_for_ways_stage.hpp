@@ -0,0 +1,267 @@
+#ifndef OSMIUM_HANDLER_NODE_LOCATIONS_FOR_WAYS_STAGE_HPP
+#define OSMIUM_HANDLER_NODE_LOCATIONS_FOR_WAYS_STAGE_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <utility>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+namespace osmium {
+
+    namespace handler {
+
+        namespace detail {
+
+            /**
+             * Pool task adding the node locations to all ways in a buffer.
+             */
+            template <class THandler>
+            class WayLocationsTask {
+
+                osmium::memory::Buffer m_buffer;
+                const THandler* m_handler;
+
+            public:
+
+                WayLocationsTask(osmium::memory::Buffer&& buffer, const THandler& handler) :
+                    m_buffer(std::move(buffer)),
+                    m_handler(&handler) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    for (auto it = m_buffer.begin<osmium::Way>(); it != m_buffer.end<osmium::Way>(); ++it) {
+                        m_handler->way_locations(*it);
+                    }
+                    return std::move(m_buffer);
+                }
+
+            }; // class WayLocationsTask
+
+            /**
+             * Pool task storing the locations of all nodes in a buffer.
+             */
+            template <class THandler>
+            class NodeIndexTask {
+
+                osmium::memory::Buffer m_buffer;
+                THandler* m_handler;
+
+            public:
+
+                NodeIndexTask(osmium::memory::Buffer&& buffer, THandler& handler) :
+                    m_buffer(std::move(buffer)),
+                    m_handler(&handler) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    m_handler->node_buffer(m_buffer);
+                    return std::move(m_buffer);
+                }
+
+            }; // class NodeIndexTask
+
+        } // namespace detail
+
+        /**
+         * Pipeline stage that adds node locations to ways using the pool
+         * threads. It reads buffers from a source (usually an
+         * osmium::io::Reader) and gives them out again in the same order
+         * from its own read() function. Use it in place of the Reader:
+         *
+         * @code{.cpp}
+         * index_type index;
+         * osmium::handler::NodeLocationsForWays<index_type> handler(index);
+         * osmium::io::Reader reader(filename);
+         * osmium::handler::NodeLocationsForWaysStage<osmium::io::Reader, decltype(handler)> stage(reader, handler);
+         * while (osmium::memory::Buffer buffer = stage.read()) {
+         *     osmium::apply(buffer, other_handlers...);
+         * }
+         * @endcode
+         *
+         * Node buffers are indexed in pool tasks through the
+         * node_buffer() function of the handler, so the storage must
+         * support concurrent writes (see VectorBasedDenseMap). Before a
+         * buffer with ways is handed to the pool, all outstanding node
+         * tasks are waited for. Each buffer with ways is then resolved in
+         * its own task, reading the index only.
+         *
+         * Input is usually sorted with all nodes before the ways. If
+         * nodes come after ways have been handed to the pool, all queued
+         * tasks are waited for and the nodes are indexed in the calling
+         * thread, so the index is never written while a way task reads
+         * it. This works, but it is slow if it happens often.
+         *
+         * Any exception from a task (such as osmium::not_found if the
+         * handler does not ignore errors) is re-thrown from read().
+         *
+         * @tparam TSource Class with a read() function returning Buffers,
+         *                 an invalid Buffer signals end-of-data.
+         * @tparam THandler NodeLocationsForWays handler.
+         */
+        template <class TSource, class THandler>
+        class NodeLocationsForWaysStage {
+
+            TSource& m_source;
+            THandler& m_handler;
+            std::deque<std::future<osmium::memory::Buffer>> m_queue {};
+            const size_t m_max_queue_size;
+            bool m_nodes_pending {false};
+            bool m_ways_pending {false};
+            bool m_input_done {false};
+
+            static std::future<osmium::memory::Buffer> ready_future(osmium::memory::Buffer&& buffer) {
+                std::promise<osmium::memory::Buffer> promise;
+                std::future<osmium::memory::Buffer> future = promise.get_future();
+                promise.set_value(std::move(buffer));
+                return future;
+            }
+
+            // Wait until all queued tasks are done. Then all nodes read so
+            // far are in the index and nobody is reading it.
+            void wait_for_tasks() {
+                for (auto& future : m_queue) {
+                    future.wait();
+                }
+                m_nodes_pending = false;
+                m_ways_pending = false;
+            }
+
+            void enqueue(osmium::memory::Buffer&& buffer) {
+                bool has_nodes = false;
+                bool has_ways = false;
+                for (auto it = buffer.cbegin(); it != buffer.cend() && !(has_nodes && has_ways); ++it) {
+                    if (it->type() == osmium::item_type::node) {
+                        has_nodes = true;
+                    } else if (it->type() == osmium::item_type::way) {
+                        has_ways = true;
+                    }
+                }
+
+                if (has_nodes && m_ways_pending) {
+                    // Nodes after ways. Way tasks might still be reading
+                    // the index, so wait for them before writing to it.
+                    wait_for_tasks();
+                    m_handler.node_buffer(buffer);
+                    if (!has_ways) {
+                        m_queue.push_back(ready_future(std::move(buffer)));
+                        return;
+                    }
+                    has_nodes = false;
+                }
+
+                if (has_ways) {
+                    if (m_nodes_pending) {
+                        wait_for_tasks();
+                    }
+                    if (has_nodes) {
+                        m_handler.node_buffer(buffer);
+                    }
+                    m_handler.prepare_for_lookup();
+                    m_ways_pending = true;
+                    m_queue.push_back(osmium::thread::Pool::instance().submit(detail::WayLocationsTask<THandler>(std::move(buffer), m_handler)));
+                } else if (has_nodes) {
+                    m_nodes_pending = true;
+                    m_queue.push_back(osmium::thread::Pool::instance().submit(detail::NodeIndexTask<THandler>(std::move(buffer), m_handler)));
+                } else {
+                    m_queue.push_back(ready_future(std::move(buffer)));
+                }
+            }
+
+        public:
+
+            /**
+             * Constructor.
+             *
+             * @param source Source of buffers.
+             * @param handler NodeLocationsForWays handler with the index.
+             * @param max_queue_size Maximum number of buffers read ahead
+             *                       from the source.
+             */
+            explicit NodeLocationsForWaysStage(TSource& source, THandler& handler, const size_t max_queue_size = 20) :
+                m_source(source),
+                m_handler(handler),
+                m_max_queue_size(max_queue_size) {
+            }
+
+            NodeLocationsForWaysStage(const NodeLocationsForWaysStage&) = delete;
+            NodeLocationsForWaysStage& operator=(const NodeLocationsForWaysStage&) = delete;
+
+            ~NodeLocationsForWaysStage() {
+                // Pool tasks reference the handler, so make sure they are
+                // all done before we go away.
+                for (auto& future : m_queue) {
+                    if (future.valid()) {
+                        future.wait();
+                    }
+                }
+            }
+
+            /**
+             * Get the next buffer with all way node locations filled in.
+             * An invalid buffer signals end-of-data.
+             *
+             * @throws Any exception thrown by the source or in a task.
+             */
+            osmium::memory::Buffer read() {
+                while (!m_input_done && m_queue.size() < m_max_queue_size) {
+                    osmium::memory::Buffer buffer = m_source.read();
+                    if (!buffer) {
+                        m_input_done = true;
+                        break;
+                    }
+                    enqueue(std::move(buffer));
+                }
+
+                if (m_queue.empty()) {
+                    return osmium::memory::Buffer();
+                }
+
+                std::future<osmium::memory::Buffer> future = std::move(m_queue.front());
+                m_queue.pop_front();
+                return future.get();
+            }
+
+        }; // class NodeLocationsForWaysStage
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_NODE_LOCATIONS_FOR_WAYS_STAGE_HPP
@@ -46,6 +46,14 @@ namespace osmium {
     namespace handler {
 
         /**
+         * This handler fills indexes from nodes to the ways and relations
+         * they are in, from ways to the relations they are in, and from
+         * relations to their parent relations.
+         *
+         * For large inputs use index::multimap::CsrMultimap for the
+         * indexes and call sort() on them after reading the data. It
+         * needs only a few bytes per entry and the result can be dumped
+         * to disk and mmap'ed for queries.
          *
          * Note: This handler will only work if either all object IDs are
          *       positive or all object IDs are negative.
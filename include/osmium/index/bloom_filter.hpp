@@ -0,0 +1,205 @@
+#ifndef OSMIUM_INDEX_BLOOM_FILTER_HPP
+#define OSMIUM_INDEX_BLOOM_FILTER_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <osmium/osm/types.hpp>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * A blocked Bloom filter for ids. It can tell for sure that an
+         * id was not inserted, but sometimes gives false positives.
+         *
+         * All bits for one id are in the same 512 bit block, which is
+         * aligned to a cache line, so each lookup needs only a single
+         * memory access. With the default of 10 bits per element about
+         * 1% of the lookups for ids not in the filter are false positives.
+         *
+         * @tparam TId Type of the ids, must be an unsigned integral type.
+         */
+        template <typename TId = osmium::unsigned_object_id_type>
+        class BloomFilter {
+
+            static constexpr size_t block_bits = 512;
+            static constexpr size_t block_words = block_bits / 64;
+            static constexpr size_t cache_line_size = 64;
+            static constexpr unsigned int num_probes = 6;
+
+            std::vector<uint64_t> m_storage;
+            uint64_t* m_blocks;
+            uint64_t m_block_mask;
+
+            // Mixing function from splitmix64.
+            static uint64_t hash(uint64_t x) {
+                x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+                return x ^ (x >> 31);
+            }
+
+            // The block is selected with the low bits of the hash, the
+            // bits inside the block with a second hash derived from it.
+            const uint64_t* block(const uint64_t h) const {
+                return m_blocks + (h & m_block_mask) * block_words;
+            }
+
+            uint64_t* block(const uint64_t h) {
+                return m_blocks + (h & m_block_mask) * block_words;
+            }
+
+        public:
+
+            /**
+             * Create a filter sized for the expected number of elements.
+             * If you don't know that yet, call reset() later. A filter
+             * without elements gets a single block on the first insert().
+             */
+            explicit BloomFilter(const size_t expected_elements = 0, const unsigned int bits_per_element = 10) :
+                m_storage(),
+                m_blocks(nullptr),
+                m_block_mask(0) {
+                reset(expected_elements, bits_per_element);
+            }
+
+            BloomFilter(const BloomFilter&) = delete;
+            BloomFilter& operator=(const BloomFilter&) = delete;
+
+            /**
+             * Moving leaves the other filter empty. (The default move
+             * would leave its m_blocks pointing into our storage.)
+             */
+            BloomFilter(BloomFilter&& other) noexcept :
+                m_storage(std::move(other.m_storage)),
+                m_blocks(other.m_blocks),
+                m_block_mask(other.m_block_mask) {
+                other.clear();
+            }
+
+            BloomFilter& operator=(BloomFilter&& other) noexcept {
+                if (this != &other) {
+                    m_storage = std::move(other.m_storage);
+                    m_blocks = other.m_blocks;
+                    m_block_mask = other.m_block_mask;
+                    other.clear();
+                }
+                return *this;
+            }
+
+            ~BloomFilter() = default;
+
+            /**
+             * Remove all elements and resize the filter for the expected
+             * number of elements.
+             */
+            void reset(const size_t expected_elements, const unsigned int bits_per_element = 10) {
+                if (expected_elements == 0) {
+                    clear();
+                    return;
+                }
+
+                size_t num_blocks = 1;
+                while (num_blocks * block_bits < expected_elements * bits_per_element) {
+                    num_blocks <<= 1;
+                }
+
+                // Allocate a bit more so we can align the blocks to
+                // cache lines.
+                std::vector<uint64_t> storage(num_blocks * block_words + cache_line_size / sizeof(uint64_t));
+                m_storage.swap(storage);
+                const uintptr_t address = reinterpret_cast<uintptr_t>(m_storage.data());
+                const uintptr_t aligned = (address + cache_line_size - 1) & ~static_cast<uintptr_t>(cache_line_size - 1);
+                m_blocks = m_storage.data() + (aligned - address) / sizeof(uint64_t);
+                m_block_mask = num_blocks - 1;
+            }
+
+            void insert(const TId id) {
+                // An empty filter (default constructed, cleared, or moved
+                // from) has no blocks yet, give it the smallest size.
+                if (!m_blocks) {
+                    reset(1);
+                }
+                const uint64_t h = hash(static_cast<uint64_t>(id));
+                uint64_t* b = block(h);
+                uint64_t bits = hash(h);
+                for (unsigned int i = 0; i < num_probes; ++i) {
+                    b[(bits >> 6) & (block_words - 1)] |= static_cast<uint64_t>(1) << (bits & 63);
+                    bits >>= 9;
+                }
+            }
+
+            /**
+             * Check whether the id might be in the filter.
+             *
+             * @returns false if the id is definitely not in the filter,
+             *          true if it probably is.
+             */
+            bool maybe_contains(const TId id) const {
+                if (!m_blocks) {
+                    return false;
+                }
+                const uint64_t h = hash(static_cast<uint64_t>(id));
+                const uint64_t* b = block(h);
+                uint64_t bits = hash(h);
+                for (unsigned int i = 0; i < num_probes; ++i) {
+                    if (!(b[(bits >> 6) & (block_words - 1)] & (static_cast<uint64_t>(1) << (bits & 63)))) {
+                        return false;
+                    }
+                    bits >>= 9;
+                }
+                return true;
+            }
+
+            size_t used_memory() const {
+                return m_storage.capacity() * sizeof(uint64_t);
+            }
+
+            void clear() {
+                std::vector<uint64_t>().swap(m_storage);
+                m_blocks = nullptr;
+                m_block_mask = 0;
+            }
+
+        }; // class BloomFilter
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_BLOOM_FILTER_HPP
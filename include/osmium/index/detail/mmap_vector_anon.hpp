@@ -64,6 +64,7 @@ namespace osmium {
                 if (new_capacity > this->capacity()) {
                     this->data(osmium::detail::typed_mmap<T>::remap(this->data(), this->capacity(), new_capacity));
                     this->m_capacity = new_capacity;
+                    this->apply_advice();
                 }
             }
 
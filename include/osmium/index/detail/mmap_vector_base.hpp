@@ -43,8 +43,27 @@ namespace osmium {
 
     namespace detail {
 
+        /**
+         * Initial capacity (in objects) of the mmap based vectors.
+         */
         constexpr size_t mmap_vector_size_increment = 1024 * 1024;
 
+        /**
+         * The mmap based vectors double their capacity when they have to
+         * grow, but never by more than this many objects at a time.
+         */
+        constexpr size_t mmap_vector_max_size_increment = 128 * 1024 * 1024;
+
+        /**
+         * Calculate the capacity a vector with the given capacity should
+         * grow to if it has to hold at least new_size objects.
+         */
+        inline size_t mmap_vector_grow_capacity(size_t capacity, size_t new_size) {
+            const size_t increment = capacity < mmap_vector_size_increment ? mmap_vector_size_increment :
+                                     capacity > mmap_vector_max_size_increment ? mmap_vector_max_size_increment : capacity;
+            return new_size > capacity + increment ? new_size : capacity + increment;
+        }
+
         /**
          * This is a base class for implementing classes that look like
          * STL vector but use mmap internally. This class can not be used
@@ -60,6 +79,7 @@ namespace osmium {
             size_t m_capacity;
             size_t m_size;
             T* m_data;
+            mmap_advice m_advice {mmap_advice::normal};
 
             explicit mmap_vector_base(int fd, size_t capacity, size_t size, T* data) :
                 m_fd(fd),
@@ -79,6 +99,16 @@ namespace osmium {
                 m_data = data;
             }
 
+            /**
+             * Give the advice set with advise() again. Must be called
+             * by the derived classes after the memory was mapped anew.
+             */
+            void apply_advice() {
+                if (m_advice != mmap_advice::normal) {
+                    osmium::detail::typed_mmap<T>::advise(m_data, m_capacity, m_advice);
+                }
+            }
+
         public:
 
             typedef T value_type;
@@ -128,13 +158,30 @@ namespace osmium {
                 m_size = 0;
             }
 
+            /**
+             * Tell the kernel how this vector will be accessed, for instance
+             * mmap_advice::huge_pages to use 2 MB pages for a large location
+             * index or mmap_advice::random for lookups in it. The advice
+             * stays in effect when the vector grows.
+             *
+             * @return True if the advice was accepted, false otherwise
+             */
+            bool advise(mmap_advice advice) {
+                m_advice = advice;
+                return osmium::detail::typed_mmap<T>::advise(m_data, m_capacity, advice);
+            }
+
+            mmap_advice advice() const {
+                return m_advice;
+            }
+
             void shrink_to_fit() {
                 // XXX do something here
             }
 
             void push_back(const T& value) {
                 if (m_size >= m_capacity) {
-                    resize(m_size+1);
+                    static_cast<TDerived<T>*>(this)->reserve(osmium::detail::mmap_vector_grow_capacity(m_capacity, m_size+1));
                 }
                 m_data[m_size] = value;
                 ++m_size;
@@ -142,7 +189,7 @@ namespace osmium {
 
             void resize(size_t new_size) {
                 if (new_size > this->capacity()) {
-                    static_cast<TDerived<T>*>(this)->reserve(new_size + osmium::detail::mmap_vector_size_increment);
+                    static_cast<TDerived<T>*>(this)->reserve(osmium::detail::mmap_vector_grow_capacity(this->capacity(), new_size));
                 }
                 if (new_size > this->size()) {
                     new (this->data() + this->size()) T[new_size - this->size()];
@@ -69,8 +69,9 @@ namespace osmium {
                 if (new_capacity > this->capacity()) {
                     osmium::detail::typed_mmap<T>::unmap(this->data(), this->capacity());
                     osmium::detail::typed_mmap<T>::grow_file(new_capacity, this->m_fd);
-                    osmium::detail::typed_mmap<T>::map(new_capacity, this->m_fd);
+                    this->data(osmium::detail::typed_mmap<T>::map(new_capacity, this->m_fd, true));
                     this->m_capacity = new_capacity;
+                    this->apply_advice();
                 }
             }
 
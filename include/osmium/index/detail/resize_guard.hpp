@@ -0,0 +1,166 @@
+#ifndef OSMIUM_INDEX_DETAIL_RESIZE_GUARD_HPP
+#define OSMIUM_INDEX_DETAIL_RESIZE_GUARD_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Helper for index classes that allow several threads to write
+         * into them at the same time, but have to move their storage
+         * around in memory when growing.
+         *
+         * Writers register with enter() before touching the storage and
+         * unregister with leave(). This costs two atomic operations and
+         * no lock. A thread that needs to resize the storage calls
+         * resize(), which waits until all registered writers have left
+         * and keeps new writers out until it is done.
+         */
+        class ResizeGuard {
+
+            std::mutex m_mutex {};
+            std::atomic<int> m_writers {0};
+            std::atomic<bool> m_resizing {false};
+
+            template <typename TFunc>
+            void resize_locked(TFunc&& resize_func) {
+                m_resizing = true;
+                while (m_writers > 0) {
+                    std::this_thread::yield();
+                }
+                try {
+                    resize_func();
+                } catch (...) {
+                    m_resizing = false;
+                    throw;
+                }
+                m_resizing = false;
+            }
+
+        public:
+
+            ResizeGuard() = default;
+
+            ResizeGuard(const ResizeGuard&) = delete;
+            ResizeGuard& operator=(const ResizeGuard&) = delete;
+
+            /**
+             * Register as writer. The big_enough function is called after
+             * registering to check whether the storage is large enough for
+             * what the caller wants to write. If it is not or if some
+             * thread is resizing, this returns false and the caller is
+             * not registered.
+             */
+            template <typename TFunc>
+            bool enter(TFunc&& big_enough) {
+                ++m_writers;
+                if (m_resizing || !big_enough()) {
+                    --m_writers;
+                    return false;
+                }
+                return true;
+            }
+
+            /**
+             * Unregister writer.
+             */
+            void leave() {
+                --m_writers;
+            }
+
+            /**
+             * Calls leave() when it goes out of scope. Create one right
+             * after a successful enter(), so the writer is unregistered
+             * even if an exception is thrown while writing.
+             */
+            class Writer {
+
+                ResizeGuard& m_guard;
+
+            public:
+
+                explicit Writer(ResizeGuard& guard) :
+                    m_guard(guard) {
+                }
+
+                Writer(const Writer&) = delete;
+                Writer& operator=(const Writer&) = delete;
+
+                ~Writer() {
+                    m_guard.leave();
+                }
+
+            }; // class Writer
+
+            /**
+             * Call the resize_func function when no writer is active.
+             * Only one thread can resize at a time, so resize_func must
+             * check itself whether another thread already did the work.
+             */
+            template <typename TFunc>
+            void resize(TFunc&& resize_func) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                resize_locked(std::forward<TFunc>(resize_func));
+            }
+
+            /**
+             * Like resize(), but first call grow_in_place_func without
+             * waiting for the writers. It must return true if it could
+             * make enough room without moving the storage (for instance
+             * because the capacity of a vector is large enough). Only if
+             * it returns false, resize_func is called once all writers
+             * have left. Both are called with the resize lock held.
+             */
+            template <typename TInPlaceFunc, typename TFunc>
+            void grow(TInPlaceFunc&& grow_in_place_func, TFunc&& resize_func) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (grow_in_place_func()) {
+                    return;
+                }
+                resize_locked(std::forward<TFunc>(resize_func));
+            }
+
+        }; // class ResizeGuard
+
+    } // namespace detail
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_RESIZE_GUARD_HPP
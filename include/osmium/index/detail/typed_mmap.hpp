@@ -54,6 +54,18 @@ namespace osmium {
      */
     namespace detail {
 
+        /**
+         * Access pattern hints for memory mappings. See madvise(2).
+         */
+        enum class mmap_advice : int {
+            normal        = 0, ///< No special treatment
+            sequential    = 1, ///< Pages will be accessed in sequential order
+            random        = 2, ///< Pages will be accessed in random order
+            willneed      = 3, ///< Pages will be accessed soon, read ahead
+            huge_pages    = 4, ///< Back the mapping with transparent huge pages
+            no_huge_pages = 5  ///< Never back the mapping with huge pages
+        };
+
         /**
          * This is a helper class for working with memory mapped files and
          * anonymous shared memory. It wraps the necessary system calls
@@ -79,11 +91,21 @@ namespace osmium {
              * Note that no constructor is called for any of the objects in this memory!
              *
              * @param size Number of objects of type T that should fit into this memory
+             * @param populate Pre-fault all pages (only on systems supporting
+             *                 MAP_POPULATE, ignored otherwise)
              * @return Pointer to mapped memory
              * @exception std::system_error If mmap(2) failed
              */
-            static T* map(size_t size) {
-                void* addr = ::mmap(nullptr, sizeof(T) * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            static T* map(size_t size, bool populate = false) {
+                int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+                if (populate) {
+                    flags |= MAP_POPULATE;
+                }
+#else
+                (void)populate;
+#endif
+                void* addr = ::mmap(nullptr, sizeof(T) * size, PROT_READ | PROT_WRITE, flags, -1, 0);
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
                 if (addr == MAP_FAILED) {
@@ -145,6 +167,51 @@ namespace osmium {
             }
 #endif
 
+            /**
+             * Tell the kernel how the memory will be accessed. This is only
+             * a hint, so unlike the other functions this doesn't throw. If
+             * the system doesn't know about the advice (for instance because
+             * it has no support for transparent huge pages), nothing happens.
+             *
+             * The advice is lost when the memory is unmapped, so it has to be
+             * given again after mapping a file anew. (Advice given on an
+             * anonymous mapping stays with it when it is grown with remap().)
+             *
+             * @param data Pointer to the data
+             * @param size Number of objects of type T stored
+             * @param advice How the memory is going to be used
+             * @return True if the advice was accepted, false otherwise
+             */
+            static bool advise(T* data, size_t size, mmap_advice advice) {
+                int flag;
+                switch (advice) {
+                    case mmap_advice::sequential:
+                        flag = MADV_SEQUENTIAL;
+                        break;
+                    case mmap_advice::random:
+                        flag = MADV_RANDOM;
+                        break;
+                    case mmap_advice::willneed:
+                        flag = MADV_WILLNEED;
+                        break;
+#ifdef MADV_HUGEPAGE
+                    case mmap_advice::huge_pages:
+                        flag = MADV_HUGEPAGE;
+                        break;
+                    case mmap_advice::no_huge_pages:
+                        flag = MADV_NOHUGEPAGE;
+                        break;
+#else
+                    case mmap_advice::huge_pages:
+                    case mmap_advice::no_huge_pages:
+                        return false;
+#endif
+                    default:
+                        flag = MADV_NORMAL;
+                }
+                return ::madvise(reinterpret_cast<void*>(data), sizeof(T) * size, flag) == 0;
+            }
+
             /**
              * Release memory from map() call.
              *
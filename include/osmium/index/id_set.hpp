@@ -0,0 +1,541 @@
+#ifndef OSMIUM_INDEX_ID_SET_HPP
+#define OSMIUM_INDEX_ID_SET_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <osmium/osm/types.hpp>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Compressed set of IDs for fast membership tests, modelled after
+         * "Roaring Bitmaps". The ID space is split into chunks of 2^16
+         * IDs. Only chunks that contain at least one ID are stored. Each
+         * chunk is stored in one of three ways:
+         *
+         * - array: a sorted array of 16 bit values (for up to 4096 IDs)
+         * - bitmap: a bitmap with one bit for each of the 2^16 IDs
+         * - run: a sorted list of (first, last) ranges of IDs
+         *
+         * Chunks are switched between array and bitmap automatically when
+         * IDs are added. Call optimize() after filling the set to convert
+         * chunks into runs where this saves memory, for instance when
+         * whole ranges of IDs are in the set.
+         *
+         * @tparam TId Id type, usually osmium::unsigned_object_id_type,
+         *             must be an unsigned integral type.
+         */
+        template <typename TId = osmium::unsigned_object_id_type>
+        class IdSet {
+
+            static_assert(std::is_integral<TId>::value && std::is_unsigned<TId>::value,
+                          "TId template parameter for class IdSet must be unsigned integral type");
+
+            class Chunk {
+
+            public:
+
+                enum class kind : uint8_t {
+                    array  = 0,
+                    bitmap = 1,
+                    run    = 2
+                };
+
+                /// Chunks with more values than this are stored as bitmaps.
+                static constexpr size_t max_array_size = 4096;
+
+                static constexpr size_t bitmap_words = (1 << 16) / 64;
+
+            private:
+
+                // Sorted values for arrays, (first, last) pairs for runs.
+                std::vector<uint16_t> m_values;
+
+                // Bits for bitmaps.
+                std::vector<uint64_t> m_bits;
+
+                uint32_t m_size;
+
+                kind m_kind;
+
+                bool bit_is_set(const uint16_t value) const {
+                    return (m_bits[value >> 6] & (1ULL << (value & 0x3f))) != 0;
+                }
+
+                void recount() {
+                    m_size = 0;
+                    for (const uint64_t word : m_bits) {
+                        m_size += static_cast<uint32_t>(std::bitset<64>(word).count());
+                    }
+                }
+
+                void set_values(std::vector<uint16_t>&& values) {
+                    m_bits.clear();
+                    m_bits.shrink_to_fit();
+                    m_size = static_cast<uint32_t>(values.size());
+                    m_kind = kind::array;
+                    if (m_size > max_array_size) {
+                        to_bitmap(values);
+                    } else {
+                        m_values = std::move(values);
+                    }
+                }
+
+                void to_bitmap(const std::vector<uint16_t>& values) {
+                    m_bits.assign(bitmap_words, 0);
+                    for (const uint16_t value : values) {
+                        m_bits[value >> 6] |= 1ULL << (value & 0x3f);
+                    }
+                    m_size = static_cast<uint32_t>(values.size());
+                    m_values.clear();
+                    m_values.shrink_to_fit();
+                    m_kind = kind::bitmap;
+                }
+
+            public:
+
+                Chunk() :
+                    m_values(),
+                    m_bits(),
+                    m_size(0),
+                    m_kind(kind::array) {
+                }
+
+                kind type() const {
+                    return m_kind;
+                }
+
+                size_t size() const {
+                    return m_size;
+                }
+
+                bool empty() const {
+                    return m_size == 0;
+                }
+
+                size_t used_memory() const {
+                    return m_values.capacity() * sizeof(uint16_t) + m_bits.capacity() * sizeof(uint64_t) + sizeof(Chunk);
+                }
+
+                bool contains(const uint16_t value) const {
+                    switch (m_kind) {
+                        case kind::array:
+                            return std::binary_search(m_values.cbegin(), m_values.cend(), value);
+                        case kind::bitmap:
+                            return bit_is_set(value);
+                        case kind::run:
+                            break;
+                    }
+                    // Find first run starting after value, the run before
+                    // that is the only one that can contain it.
+                    size_t lo = 0;
+                    size_t hi = m_values.size() / 2;
+                    while (lo < hi) {
+                        const size_t mid = (lo + hi) / 2;
+                        if (m_values[mid * 2] <= value) {
+                            lo = mid + 1;
+                        } else {
+                            hi = mid;
+                        }
+                    }
+                    return lo > 0 && value <= m_values[lo * 2 - 1];
+                }
+
+                /**
+                 * Call func with each value in this chunk in order.
+                 */
+                template <typename TFunc>
+                void for_each(TFunc&& func) const {
+                    switch (m_kind) {
+                        case kind::array:
+                            for (const uint16_t value : m_values) {
+                                func(value);
+                            }
+                            break;
+                        case kind::bitmap:
+                            for (size_t i = 0; i < bitmap_words; ++i) {
+                                uint64_t word = m_bits[i];
+                                while (word) {
+                                    const uint64_t lowest = word & (~word + 1);
+                                    func(static_cast<uint16_t>(i * 64 + std::bitset<64>(lowest - 1).count()));
+                                    word ^= lowest;
+                                }
+                            }
+                            break;
+                        case kind::run:
+                            for (size_t i = 0; i < m_values.size(); i += 2) {
+                                for (uint32_t value = m_values[i]; value <= m_values[i + 1]; ++value) {
+                                    func(static_cast<uint16_t>(value));
+                                }
+                            }
+                            break;
+                    }
+                }
+
+                std::vector<uint16_t> values() const {
+                    if (m_kind == kind::array) {
+                        return m_values;
+                    }
+                    std::vector<uint16_t> values;
+                    values.reserve(m_size);
+                    for_each([&values](uint16_t value) {
+                        values.push_back(value);
+                    });
+                    return values;
+                }
+
+                /**
+                 * Run chunks can not be modified in place. This converts
+                 * them to array or bitmap chunks.
+                 */
+                void make_modifiable() {
+                    if (m_kind == kind::run) {
+                        set_values(values());
+                    }
+                }
+
+                void insert(const uint16_t value) {
+                    make_modifiable();
+                    if (m_kind == kind::bitmap) {
+                        if (!bit_is_set(value)) {
+                            m_bits[value >> 6] |= 1ULL << (value & 0x3f);
+                            ++m_size;
+                        }
+                        return;
+                    }
+                    const auto it = std::lower_bound(m_values.begin(), m_values.end(), value);
+                    if (it != m_values.end() && *it == value) {
+                        return;
+                    }
+                    m_values.insert(it, value);
+                    ++m_size;
+                    if (m_size > max_array_size) {
+                        to_bitmap(m_values);
+                    }
+                }
+
+                /**
+                 * Add all values from the sorted range [begin, end) without
+                 * duplicates.
+                 */
+                template <typename TIterator>
+                void insert_sorted(TIterator begin, TIterator end) {
+                    make_modifiable();
+                    if (m_kind == kind::bitmap) {
+                        for (; begin != end; ++begin) {
+                            m_bits[*begin >> 6] |= 1ULL << (*begin & 0x3f);
+                        }
+                        recount();
+                        return;
+                    }
+                    std::vector<uint16_t> merged;
+                    merged.reserve(m_values.size() + std::distance(begin, end));
+                    std::set_union(m_values.cbegin(), m_values.cend(), begin, end, std::back_inserter(merged));
+                    set_values(std::move(merged));
+                }
+
+                void merge(const Chunk& other) {
+                    make_modifiable();
+                    if (m_kind == kind::bitmap && other.m_kind == kind::bitmap) {
+                        for (size_t i = 0; i < bitmap_words; ++i) {
+                            m_bits[i] |= other.m_bits[i];
+                        }
+                        recount();
+                    } else {
+                        const std::vector<uint16_t> other_values = other.values();
+                        insert_sorted(other_values.cbegin(), other_values.cend());
+                    }
+                }
+
+                void intersect(const Chunk& other) {
+                    make_modifiable();
+                    if (m_kind == kind::bitmap && other.m_kind == kind::bitmap) {
+                        for (size_t i = 0; i < bitmap_words; ++i) {
+                            m_bits[i] &= other.m_bits[i];
+                        }
+                        recount();
+                        if (m_size <= max_array_size) {
+                            set_values(values());
+                        }
+                        return;
+                    }
+                    std::vector<uint16_t> result;
+                    for_each([&result, &other](uint16_t value) {
+                        if (other.contains(value)) {
+                            result.push_back(value);
+                        }
+                    });
+                    set_values(std::move(result));
+                }
+
+                /**
+                 * Convert into the representation using the least memory.
+                 */
+                void optimize() {
+                    std::vector<uint16_t> runs;
+                    for_each([&runs](uint16_t value) {
+                        if (!runs.empty() && runs.back() + 1 == value) {
+                            runs.back() = value;
+                        } else {
+                            runs.push_back(value);
+                            runs.push_back(value);
+                        }
+                    });
+
+                    const size_t run_bytes = runs.size() * sizeof(uint16_t);
+                    const size_t array_bytes = m_size * sizeof(uint16_t);
+                    const size_t bitmap_bytes = bitmap_words * sizeof(uint64_t);
+
+                    if (run_bytes < array_bytes && run_bytes < bitmap_bytes) {
+                        m_bits.clear();
+                        m_bits.shrink_to_fit();
+                        runs.shrink_to_fit();
+                        m_values = std::move(runs);
+                        m_kind = kind::run;
+                    } else if (m_kind == kind::run) {
+                        set_values(values());
+                    } else {
+                        m_values.shrink_to_fit();
+                    }
+                }
+
+            }; // class Chunk
+
+            typedef std::pair<TId, Chunk> chunk_type;
+
+            // Chunks sorted by key (the ID shifted right by 16 bits).
+            std::vector<chunk_type> m_chunks;
+
+            static TId key(const TId id) {
+                return id >> 16;
+            }
+
+            static uint16_t low_bits(const TId id) {
+                return static_cast<uint16_t>(id & 0xffff);
+            }
+
+            typename std::vector<chunk_type>::const_iterator find_chunk(const TId chunk_key) const {
+                // IDs are often added and looked up in order, so check the
+                // last chunk before doing the binary search.
+                if (!m_chunks.empty() && m_chunks.back().first == chunk_key) {
+                    return m_chunks.cend() - 1;
+                }
+                const auto it = std::lower_bound(m_chunks.cbegin(), m_chunks.cend(), chunk_key, [](const chunk_type& chunk, TId k) {
+                    return chunk.first < k;
+                });
+                if (it != m_chunks.cend() && it->first == chunk_key) {
+                    return it;
+                }
+                return m_chunks.cend();
+            }
+
+            Chunk& get_or_add_chunk(const TId chunk_key) {
+                if (m_chunks.empty() || m_chunks.back().first < chunk_key) {
+                    m_chunks.emplace_back(chunk_key, Chunk());
+                    return m_chunks.back().second;
+                }
+                auto it = std::lower_bound(m_chunks.begin(), m_chunks.end(), chunk_key, [](const chunk_type& chunk, TId k) {
+                    return chunk.first < k;
+                });
+                if (it == m_chunks.end() || it->first != chunk_key) {
+                    it = m_chunks.emplace(it, chunk_key, Chunk());
+                }
+                return it->second;
+            }
+
+        public:
+
+            typedef TId value_type;
+
+            IdSet() :
+                m_chunks() {
+            }
+
+            /**
+             * Add an ID to the set.
+             */
+            void insert(const TId id) {
+                get_or_add_chunk(key(id)).insert(low_bits(id));
+            }
+
+            /**
+             * Add all IDs from the range [begin, end) to the set. The IDs
+             * do not have to be sorted or unique. This is much faster than
+             * calling insert() for each ID.
+             */
+            template <typename TIterator>
+            void insert(TIterator begin, TIterator end) {
+                std::vector<TId> ids(begin, end);
+                std::sort(ids.begin(), ids.end());
+                ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+                std::vector<uint16_t> values;
+                auto it = ids.cbegin();
+                while (it != ids.cend()) {
+                    const TId chunk_key = key(*it);
+                    values.clear();
+                    for (; it != ids.cend() && key(*it) == chunk_key; ++it) {
+                        values.push_back(low_bits(*it));
+                    }
+                    get_or_add_chunk(chunk_key).insert_sorted(values.cbegin(), values.cend());
+                }
+            }
+
+            /**
+             * Is the ID in the set?
+             */
+            bool contains(const TId id) const {
+                const auto it = find_chunk(key(id));
+                return it != m_chunks.cend() && it->second.contains(low_bits(id));
+            }
+
+            /**
+             * The number of IDs in the set.
+             */
+            size_t size() const {
+                size_t size = 0;
+                for (const auto& chunk : m_chunks) {
+                    size += chunk.second.size();
+                }
+                return size;
+            }
+
+            bool empty() const {
+                return m_chunks.empty();
+            }
+
+            /**
+             * Get the approximate memory used by this set in bytes.
+             */
+            size_t used_memory() const {
+                size_t memory = m_chunks.capacity() * sizeof(chunk_type);
+                for (const auto& chunk : m_chunks) {
+                    memory += chunk.second.used_memory() - sizeof(Chunk);
+                }
+                return memory;
+            }
+
+            void clear() {
+                m_chunks.clear();
+                m_chunks.shrink_to_fit();
+            }
+
+            /**
+             * Convert all chunks into the representation that uses the least
+             * memory. Call this after the set has been filled.
+             */
+            void optimize() {
+                for (auto& chunk : m_chunks) {
+                    chunk.second.optimize();
+                }
+                m_chunks.shrink_to_fit();
+            }
+
+            /**
+             * Call func with each ID in the set in ascending order.
+             */
+            template <typename TFunc>
+            void for_each(TFunc&& func) const {
+                for (const auto& chunk : m_chunks) {
+                    const TId base = chunk.first << 16;
+                    chunk.second.for_each([&func, base](uint16_t value) {
+                        func(base | value);
+                    });
+                }
+            }
+
+            /**
+             * Add all IDs from the other set to this set (set union).
+             */
+            IdSet& operator|=(const IdSet& other) {
+                for (const auto& chunk : other.m_chunks) {
+                    get_or_add_chunk(chunk.first).merge(chunk.second);
+                }
+                return *this;
+            }
+
+            /**
+             * Remove all IDs from this set that are not in the other set
+             * (set intersection).
+             */
+            IdSet& operator&=(const IdSet& other) {
+                std::vector<chunk_type> result;
+                auto it = other.m_chunks.cbegin();
+                for (auto& chunk : m_chunks) {
+                    while (it != other.m_chunks.cend() && it->first < chunk.first) {
+                        ++it;
+                    }
+                    if (it == other.m_chunks.cend()) {
+                        break;
+                    }
+                    if (it->first == chunk.first) {
+                        chunk.second.intersect(it->second);
+                        if (!chunk.second.empty()) {
+                            result.push_back(std::move(chunk));
+                        }
+                    }
+                }
+                m_chunks = std::move(result);
+                return *this;
+            }
+
+        }; // class IdSet
+
+        template <typename TId>
+        inline IdSet<TId> operator|(IdSet<TId> lhs, const IdSet<TId>& rhs) {
+            lhs |= rhs;
+            return lhs;
+        }
+
+        template <typename TId>
+        inline IdSet<TId> operator&(IdSet<TId> lhs, const IdSet<TId>& rhs) {
+            lhs &= rhs;
+            return lhs;
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_SET_HPP
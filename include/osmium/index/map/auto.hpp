@@ -0,0 +1,379 @@
+#ifndef OSMIUM_INDEX_MAP_AUTO_HPP
+#define OSMIUM_INDEX_MAP_AUTO_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <osmium/index/map.hpp>
+#include <osmium/index/map/mmap_vector_anon.hpp>
+#include <osmium/index/map/mmap_vector_file.hpp>
+#include <osmium/index/map/sparse_table.hpp>
+#include <osmium/index/map/stl_vector.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * The different kinds of map backends create_map() can create.
+             */
+            enum class map_type : int {
+                sparse_table = 0, ///< SparseTable
+                dense_mem    = 1, ///< DenseMapMmap (on Linux) or DenseMapMem
+                dense_file   = 2, ///< DenseMapFile
+                sparse_file  = 3  ///< SparseMapFile
+            };
+
+            /**
+             * Information about some input used to choose a map backend.
+             * Fill it from the file header with box() and by calling add()
+             * with the buffers of a quick scan through the nodes of the
+             * input file (use a Reader with osmium::osm_entity_bits::node).
+             * If you know the number of nodes from somewhere else, you can
+             * set it with num_ids().
+             */
+            class InputStatistics {
+
+                osmium::Box m_box {};
+                size_t m_num_ids {0};
+                osmium::unsigned_object_id_type m_max_id {0};
+
+            public:
+
+                InputStatistics() = default;
+
+                const osmium::Box& box() const {
+                    return m_box;
+                }
+
+                InputStatistics& box(const osmium::Box& box) {
+                    m_box = box;
+                    return *this;
+                }
+
+                size_t num_ids() const {
+                    return m_num_ids;
+                }
+
+                InputStatistics& num_ids(const size_t num) {
+                    m_num_ids = num;
+                    return *this;
+                }
+
+                osmium::unsigned_object_id_type max_id() const {
+                    return m_max_id;
+                }
+
+                InputStatistics& max_id(const osmium::unsigned_object_id_type id) {
+                    m_max_id = id;
+                    return *this;
+                }
+
+                /**
+                 * Add one id.
+                 */
+                void add(const osmium::unsigned_object_id_type id) {
+                    ++m_num_ids;
+                    if (id > m_max_id) {
+                        m_max_id = id;
+                    }
+                }
+
+                /**
+                 * Add the (positive) ids of all nodes in the buffer.
+                 */
+                void add(const osmium::memory::Buffer& buffer) {
+                    for (auto it = buffer.cbegin<osmium::Node>(); it != buffer.cend<osmium::Node>(); ++it) {
+                        if (it->id() >= 0) {
+                            add(it->positive_id());
+                        }
+                    }
+                }
+
+                /**
+                 * Fraction of the id range that is actually used.
+                 */
+                double density() const {
+                    return static_cast<double>(m_num_ids) / (static_cast<double>(m_max_id) + 1);
+                }
+
+            }; // class InputStatistics
+
+            /**
+             * Get the amount of main memory available in bytes. Returns
+             * the maximum size_t value if this is unknown.
+             */
+            inline size_t available_memory() {
+#ifdef _SC_AVPHYS_PAGES
+                const long pages = ::sysconf(_SC_AVPHYS_PAGES);
+                const long page_size = ::sysconf(_SC_PAGE_SIZE);
+                if (pages > 0 && page_size > 0) {
+                    return static_cast<size_t>(pages) * static_cast<size_t>(page_size);
+                }
+#endif
+                return std::numeric_limits<size_t>::max();
+            }
+
+            /**
+             * Rough upper bound for the largest node id in a current planet
+             * file. Used to estimate the size of a dense map if only the
+             * bounding box of the input is known.
+             */
+            constexpr osmium::unsigned_object_id_type planet_max_node_id = 16ULL * 1000 * 1000 * 1000;
+
+            /**
+             * Choose the map backend using the least resources for the
+             * given input.
+             *
+             * If the number of ids and the maximum id are known from
+             * a scan of the input, a dense map is used if at least the
+             * density_threshold fraction of the id range is used, a
+             * SparseTable otherwise. If the bounding box of the input
+             * covers most of the world, we assume it is a planet file
+             * and use a dense map with room for planet_max_node_id ids
+             * (or the maximum id if that is known). If nothing is known,
+             * we use a
+             * SparseTable, because it can handle anything from small
+             * extracts to the planet.
+             *
+             * If the chosen backend would need more than 3/4 of the
+             * available memory, the file based version is chosen instead.
+             *
+             * @param stats Information about the input.
+             * @param memory Available memory in bytes.
+             * @param density_threshold Use dense maps above this density.
+             * @tparam TValue Type of values stored in the map.
+             */
+            template <typename TValue>
+            inline map_type choose_map_type(const InputStatistics& stats, const size_t memory = available_memory(), const double density_threshold = 0.5) {
+                const double memory_budget = static_cast<double>(memory / 4 * 3);
+
+                if (stats.num_ids() == 0 || stats.max_id() == 0) {
+                    const osmium::Box& box = stats.box();
+                    if (box && box.valid() && box.size() > 360.0 * 180.0 / 2) {
+                        const double range = static_cast<double>(stats.max_id() > 0 ? stats.max_id() : planet_max_node_id) + 1;
+                        return range * sizeof(TValue) <= memory_budget ? map_type::dense_mem : map_type::dense_file;
+                    }
+                    return map_type::sparse_table;
+                }
+
+                const double range = static_cast<double>(stats.max_id()) + 1;
+                if (stats.density() >= density_threshold) {
+                    return range * sizeof(TValue) <= memory_budget ? map_type::dense_mem : map_type::dense_file;
+                }
+
+                // A SparseTable needs a bit more than one bit per id in
+                // the range plus the values.
+                const double table_size = range / 4 + static_cast<double>(stats.num_ids()) * sizeof(TValue);
+                return table_size <= memory_budget ? map_type::sparse_table : map_type::sparse_file;
+            }
+
+            /**
+             * Create a map of the given type.
+             */
+            template <typename TId, typename TValue>
+            inline std::unique_ptr<Map<TId, TValue>> create_map(const map_type type) {
+                switch (type) {
+                    case map_type::sparse_table:
+                        return std::unique_ptr<Map<TId, TValue>>(new SparseTable<TId, TValue>());
+                    case map_type::dense_mem:
+#ifdef __linux__
+                        return std::unique_ptr<Map<TId, TValue>>(new DenseMapMmap<TId, TValue>());
+#else
+                        return std::unique_ptr<Map<TId, TValue>>(new DenseMapMem<TId, TValue>());
+#endif
+                    case map_type::dense_file:
+                        return std::unique_ptr<Map<TId, TValue>>(new DenseMapFile<TId, TValue>());
+                    case map_type::sparse_file:
+                        return std::unique_ptr<Map<TId, TValue>>(new SparseMapFile<TId, TValue>());
+                }
+                throw std::invalid_argument("unknown map type");
+            }
+
+            /**
+             * Create the map best suited for the given input. See
+             * choose_map_type() for details.
+             */
+            template <typename TId, typename TValue>
+            inline std::unique_ptr<Map<TId, TValue>> create_map(const InputStatistics& stats, const size_t memory = available_memory(), const double density_threshold = 0.5) {
+                const map_type type = choose_map_type<TValue>(stats, memory, density_threshold);
+#ifdef __linux__
+                if (type == map_type::dense_mem) {
+                    // Most of the pages of a dense index are going to be
+                    // used anyway, so back it with huge pages.
+                    std::unique_ptr<DenseMapMmap<TId, TValue>> map(new DenseMapMmap<TId, TValue>());
+                    if (stats.max_id() > 0) {
+                        map->reserve(stats.max_id() + 1);
+                    }
+                    map->advise(osmium::detail::mmap_advice::huge_pages);
+                    return std::unique_ptr<Map<TId, TValue>>(map.release());
+                }
+#endif
+                std::unique_ptr<Map<TId, TValue>> map = create_map<TId, TValue>(type);
+                if (stats.max_id() > 0 && stats.density() >= density_threshold) {
+                    map->reserve(stats.max_id() + 1);
+                }
+                return map;
+            }
+
+            /**
+             * Map that starts out as a SparseTable and switches to a dense
+             * map once the density of used ids passes a threshold. Use this
+             * if you don't know anything about the input beforehand.
+             *
+             * The check is done every check_interval calls to set() and
+             * only once the map contains at least min_dense_size elements,
+             * so small inputs always stay in the SparseTable.
+             */
+            template <typename TId, typename TValue>
+            class AdaptiveMap : public osmium::index::map::Map<TId, TValue> {
+
+#ifdef __linux__
+                typedef DenseMapMmap<TId, TValue> dense_type;
+#else
+                typedef DenseMapMem<TId, TValue> dense_type;
+#endif
+
+                static constexpr size_t check_interval = 64 * 1024;
+
+                std::unique_ptr<SparseTable<TId, TValue>> m_sparse;
+                std::unique_ptr<dense_type> m_dense;
+                Map<TId, TValue>* m_current;
+
+                const double m_density_threshold;
+                const size_t m_min_dense_size;
+                TId m_max_id;
+                size_t m_count;
+
+                void switch_to_dense() {
+                    m_dense.reset(new dense_type());
+                    m_dense->reserve(m_max_id + 1);
+#ifdef __linux__
+                    m_dense->advise(osmium::detail::mmap_advice::huge_pages);
+#endif
+                    dense_type* dense = m_dense.get();
+                    m_sparse->for_each([dense](TId id, const TValue& value) {
+                        dense->set(id, value);
+                    });
+                    m_sparse.reset();
+                    m_current = m_dense.get();
+                }
+
+            public:
+
+                explicit AdaptiveMap(const double density_threshold = 0.5, const size_t min_dense_size = 1024 * 1024) :
+                    m_sparse(new SparseTable<TId, TValue>()),
+                    m_dense(),
+                    m_current(m_sparse.get()),
+                    m_density_threshold(density_threshold),
+                    m_min_dense_size(min_dense_size),
+                    m_max_id(0),
+                    m_count(0) {
+                }
+
+                ~AdaptiveMap() override final = default;
+
+                /**
+                 * Has this map switched to the dense representation?
+                 */
+                bool is_dense() const {
+                    return m_dense != nullptr;
+                }
+
+                void reserve(const size_t size) override final {
+                    m_current->reserve(size);
+                }
+
+                void set(const TId id, const TValue value) override final {
+                    m_current->set(id, value);
+                    if (id > m_max_id) {
+                        m_max_id = id;
+                    }
+                    if (!m_dense && ++m_count % check_interval == 0) {
+                        const size_t size = m_sparse->size();
+                        if (size >= m_min_dense_size && static_cast<double>(size) >= m_density_threshold * (static_cast<double>(m_max_id) + 1)) {
+                            switch_to_dense();
+                        }
+                    }
+                }
+
+                const TValue get(const TId id) const override final {
+                    return m_current->get(id);
+                }
+
+                size_t size() const override final {
+                    return m_current->size();
+                }
+
+                size_t used_memory() const override final {
+                    return m_current->used_memory();
+                }
+
+                /**
+                 * Remove all elements. The map starts out as a SparseTable
+                 * again.
+                 */
+                void clear() override final {
+                    m_dense.reset();
+                    m_sparse.reset(new SparseTable<TId, TValue>());
+                    m_current = m_sparse.get();
+                    m_max_id = 0;
+                    m_count = 0;
+                }
+
+                void sort() override final {
+                    m_current->sort();
+                }
+
+            }; // class AdaptiveMap
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MAP_AUTO_HPP
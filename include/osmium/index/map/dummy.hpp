@@ -61,6 +61,11 @@ namespace osmium {
                     // intentionally left blank
                 }
 
+                template <typename TIterator>
+                void set_concurrently(TIterator, TIterator) {
+                    // intentionally left blank
+                }
+
                 const TValue get(const TId id) const override final {
                     not_found_error(id);
                 }
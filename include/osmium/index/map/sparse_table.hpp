@@ -33,13 +33,18 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
 #include <cstddef>
-#include <stdexcept>
+#include <cstdint>
+#include <mutex>
+#include <system_error>
 #include <utility>
 #include <vector>
 
-#include <google/sparsetable>
-
+#include <osmium/index/detail/resize_guard.hpp>
+#include <osmium/index/detail/typed_mmap.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
 
@@ -50,9 +55,16 @@ namespace osmium {
         namespace map {
 
             /**
-            * The SparseTable index stores elements in a Google sparsetable,
-            * a data structure that can hold sparsly filled tables in a
-            * very space efficient way. It will resize automatically.
+            * The SparseTable index stores elements in pages of 256 ids.
+            * Each page has a bitmap with one bit per id telling which
+            * ids are populated and a densely packed array with the values
+            * of those ids only. So unused ids take up only a bit more than
+            * one bit each, used ids sizeof(TValue) bytes. It will resize
+            * automatically.
+            *
+            * Setting values in ascending id order (as they come out of
+            * OSM files) is fast, because the value is just appended to
+            * the packed array of the page.
             *
             * Use this index if the ID space is only sparsly
             * populated, such as when working with smaller OSM files (like
@@ -63,11 +75,120 @@ namespace osmium {
             template <typename TId, typename TValue>
             class SparseTable : public osmium::index::map::Map<TId, TValue> {
 
+                static_assert(sizeof(size_t) >= 8, "SparseTable needs 64bit machine");
+
+                static constexpr size_t page_bits = 8;
+                static constexpr size_t page_size = 1 << page_bits;
+                static constexpr size_t page_mask = page_size - 1;
+                static constexpr size_t words_per_page = page_size / 64;
+
+                // Number of locks used by set_concurrently(). Each lock
+                // protects every num_page_locks-th page.
+                static constexpr size_t num_page_locks = 64;
+
+                class Page {
+
+                    uint64_t m_bits[words_per_page];
+                    std::vector<TValue> m_values;
+
+                    static size_t popcount(const uint64_t word) {
+                        return std::bitset<64>(word).count();
+                    }
+
+                    // Number of populated slots before slot n.
+                    size_t rank(const size_t n) const {
+                        size_t r = 0;
+                        const size_t word = n >> 6;
+                        for (size_t i = 0; i < word; ++i) {
+                            r += popcount(m_bits[i]);
+                        }
+                        return r + popcount(m_bits[word] & ((1ULL << (n & 0x3f)) - 1));
+                    }
+
+                public:
+
+                    Page() :
+                        m_bits(),
+                        m_values() {
+                    }
+
+                    bool has(const size_t n) const {
+                        return (m_bits[n >> 6] & (1ULL << (n & 0x3f))) != 0;
+                    }
+
+                    const TValue& get(const size_t n) const {
+                        return m_values[rank(n)];
+                    }
+
+                    /**
+                     * Set slot n to value.
+                     *
+                     * @returns true if the slot was empty before.
+                     */
+                    bool set(const size_t n, const TValue value) {
+                        const size_t r = rank(n);
+                        if (has(n)) {
+                            m_values[r] = value;
+                            return false;
+                        }
+                        // Only mark the slot as used once the value is in,
+                        // the page stays consistent if the allocation throws.
+                        if (r == m_values.size()) {
+                            m_values.push_back(value);
+                        } else {
+                            m_values.insert(m_values.begin() + r, value);
+                        }
+                        m_bits[n >> 6] |= 1ULL << (n & 0x3f);
+                        return true;
+                    }
+
+                    size_t size() const {
+                        return m_values.size();
+                    }
+
+                    size_t used_memory() const {
+                        return m_values.capacity() * sizeof(TValue);
+                    }
+
+                    /**
+                     * Write values of all slots into out, empty slots get
+                     * the empty value.
+                     */
+                    void expand(TValue* out) const {
+                        auto it = m_values.cbegin();
+                        for (size_t n = 0; n < page_size; ++n) {
+                            out[n] = has(n) ? *it++ : osmium::index::empty_value<TValue>();
+                        }
+                    }
+
+                    template <typename TFunc>
+                    void for_each(TFunc&& func) const {
+                        auto it = m_values.cbegin();
+                        for (size_t n = 0; n < page_size; ++n) {
+                            if (has(n)) {
+                                func(n, *it++);
+                            }
+                        }
+                    }
+
+                }; // class Page
+
                 TId m_grow_size;
 
-                google::sparsetable<TValue> m_elements;
+                std::vector<Page> m_pages;
+
+                std::atomic<size_t> m_size;
 
-                static_assert(sizeof(typename google::sparsetable<TValue>::size_type) >= 8, "google::sparsetable needs 64bit machine");
+                osmium::detail::ResizeGuard m_resize_guard {};
+
+                std::mutex m_page_locks[num_page_locks];
+
+                void grow_to(const TId id) {
+                    const size_t min_pages = (id >> page_bits) + 1;
+                    if (m_pages.size() < min_pages) {
+                        m_pages.resize(std::max(min_pages, m_pages.size() + (m_grow_size >> page_bits) + 1));
+                    }
+                }
 
             public:
 
@@ -81,52 +202,180 @@ namespace osmium {
                 */
                 explicit SparseTable(const TId grow_size=10000) :
                     m_grow_size(grow_size),
-                    m_elements(grow_size) {
+                    m_pages((grow_size >> page_bits) + 1),
+                    m_size(0) {
                 }
 
                 ~SparseTable() override final = default;
 
                 void set(const TId id, const TValue value) override final {
-                    if (id >= m_elements.size()) {
-                        m_elements.resize(id + m_grow_size);
+                    grow_to(id);
+                    if (m_pages[id >> page_bits].set(id & page_mask, value)) {
+                        ++m_size;
                     }
-                    m_elements[id] = value;
+                }
+
+                /**
+                 * Set the fields for all (id, value) pairs in the range
+                 * [begin, end).
+                 *
+                 * Like VectorBasedDenseMap::set_concurrently() this can
+                 * be called from several threads at the same time. Ids
+                 * from different pages are written in parallel, threads
+                 * writing into the same page take turns.
+                 *
+                 * You must not call set() or get() while any thread is
+                 * in this function.
+                 */
+                template <typename TIterator>
+                void set_concurrently(TIterator begin, TIterator end) {
+                    if (begin == end) {
+                        return;
+                    }
+
+                    TId max_id = 0;
+                    for (auto it = begin; it != end; ++it) {
+                        max_id = std::max(max_id, static_cast<TId>(it->first));
+                    }
+
+                    while (!m_resize_guard.enter([this, max_id]() { return m_pages.size() > (max_id >> page_bits); })) {
+                        m_resize_guard.resize([this, max_id]() {
+                            grow_to(max_id);
+                        });
+                    }
+
+                    osmium::detail::ResizeGuard::Writer writer(m_resize_guard);
+
+                    size_t added = 0;
+                    std::unique_lock<std::mutex> lock;
+                    try {
+                        for (auto it = begin; it != end; ++it) {
+                            const TId id = it->first;
+                            std::mutex* page_lock = &m_page_locks[(id >> page_bits) % num_page_locks];
+                            if (lock.mutex() != page_lock) {
+                                // Never hold two page locks at once.
+                                if (lock) {
+                                    lock.unlock();
+                                }
+                                lock = std::unique_lock<std::mutex>(*page_lock);
+                            }
+                            if (m_pages[id >> page_bits].set(id & page_mask, it->second)) {
+                                ++added;
+                            }
+                        }
+                    } catch (...) {
+                        m_size += added;
+                        throw;
+                    }
+                    m_size += added;
                 }
 
                 const TValue get(const TId id) const override final {
-                    if (id >= m_elements.size()) {
+                    const size_t page = id >> page_bits;
+                    if (page >= m_pages.size() || !m_pages[page].has(id & page_mask)) {
                         not_found_error(id);
                     }
-                    if (m_elements[id] == osmium::index::empty_value<TValue>()) {
+                    const TValue& value = m_pages[page].get(id & page_mask);
+                    if (value == osmium::index::empty_value<TValue>()) {
                         not_found_error(id);
                     }
-                    return m_elements[id];
+                    return value;
                 }
 
+                /**
+                 * The number of elements stored.
+                 */
                 size_t size() const override final {
-                    return m_elements.size();
+                    return m_size;
                 }
 
                 size_t used_memory() const override final {
-                    // unused elements use 1 bit, used elements sizeof(TValue) bytes
-                    // http://google-sparsehash.googlecode.com/svn/trunk/doc/sparsetable.html
-                    return (m_elements.size() / 8) + (m_elements.num_nonempty() * sizeof(TValue));
+                    size_t memory = m_pages.capacity() * sizeof(Page);
+                    for (const auto& page : m_pages) {
+                        memory += page.used_memory();
+                    }
+                    return memory;
                 }
 
                 void clear() override final {
-                    m_elements.clear();
+                    m_pages.clear();
+                    m_pages.shrink_to_fit();
+                    m_size = 0;
                 }
 
+                /**
+                 * Call func(id, value) for all elements in ascending id
+                 * order.
+                 */
+                template <typename TFunc>
+                void for_each(TFunc&& func) const {
+                    for (size_t p = 0; p < m_pages.size(); ++p) {
+                        const TId base = p << page_bits;
+                        m_pages[p].for_each([&func, base](size_t n, const TValue& value) {
+                            func(static_cast<TId>(base + n), value);
+                        });
+                    }
+                }
+
+                /**
+                 * Write all (id, value) pairs in ascending id order to the
+                 * file.
+                 */
                 void dump_as_list(const int fd) const {
-                    std::vector<std::pair<TId, TValue>> v;
-                    int n=0;
-                    for (const TValue value : m_elements) {
-                        if (value != osmium::index::empty_value<TValue>()) {
-                            v.emplace_back(n, value);
+                    typedef std::pair<TId, TValue> element_type;
+                    std::vector<element_type> v;
+                    for (size_t p = 0; p < m_pages.size(); ++p) {
+                        const TId base = p << page_bits;
+                        m_pages[p].for_each([&v, base](size_t n, const TValue& value) {
+                            v.emplace_back(base + n, value);
+                        });
+                        if (v.size() >= 1024 * 1024 || p + 1 == m_pages.size()) {
+                            osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(v.data()), sizeof(element_type) * v.size());
+                            v.clear();
+                        }
+                    }
+                }
+
+                /**
+                 * Write the values as one dense array indexed by id to the
+                 * file, empty values in places where no value was set. This
+                 * is the same format DenseMapFile uses, so the file can be
+                 * used with that or read back with load().
+                 */
+                void dump_as_array(const int fd) const {
+                    size_t num_pages = m_pages.size();
+                    while (num_pages > 0 && m_pages[num_pages - 1].size() == 0) {
+                        --num_pages;
+                    }
+
+                    std::vector<TValue> v(page_size);
+                    for (size_t p = 0; p < num_pages; ++p) {
+                        m_pages[p].expand(v.data());
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(v.data()), sizeof(TValue) * page_size);
+                    }
+                }
+
+                /**
+                 * Read values from a file containing one dense array indexed
+                 * by id (as written by dump_as_array() or used by
+                 * DenseMapFile). Empty values are skipped.
+                 *
+                 * @exception std::system_error If reading failed.
+                 */
+                void load(const int fd) {
+                    const size_t num_values = osmium::detail::typed_mmap<TValue>::file_size(fd);
+                    std::vector<TValue> v(page_size);
+                    for (size_t offset = 0; offset < num_values; offset += page_size) {
+                        const size_t count = num_values - offset < page_size ? num_values - offset : page_size;
+                        if (!osmium::io::detail::reliable_read(fd, reinterpret_cast<unsigned char*>(v.data()), sizeof(TValue) * count)) {
+                            throw std::system_error(0, std::system_category(), "Unexpected end of file");
+                        }
+                        for (size_t n = 0; n < count; ++n) {
+                            if (v[n] != osmium::index::empty_value<TValue>()) {
+                                set(offset + n, v[n]);
+                            }
                         }
-                        ++n;
                     }
-                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(v.data()), sizeof(std::pair<TId, TValue>) * v.size());
                 }
 
             }; // class SparseTable
@@ -137,4 +386,4 @@ namespace osmium {
 
 } // namespace osmium
 
-#endif // OSMIUM_INDEX_BYID_SPARSE_TABLE_HPP
+#endif // OSMIUM_INDEX_MAP_SPARSE_TABLE_HPP
@@ -34,10 +34,13 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <stdexcept>
 #include <utility>
 
+#include <osmium/index/detail/resize_guard.hpp>
+#include <osmium/index/detail/typed_mmap.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
 
@@ -52,6 +55,15 @@ namespace osmium {
 
                 TVector m_vector;
 
+                // Coordinates threads calling set_concurrently().
+                osmium::detail::ResizeGuard m_resize_guard {};
+
+                // Size of m_vector as seen by threads in
+                // set_concurrently(). Only updated with the resize lock
+                // held, it can be smaller than the real size if set()
+                // was used in between.
+                std::atomic<size_t> m_concurrent_size {0};
+
             public:
 
                 VectorBasedDenseMap() :
@@ -75,6 +87,66 @@ namespace osmium {
                     m_vector[id] = value;
                 }
 
+                /**
+                 * Set the fields for all (id, value) pairs in the range
+                 * [begin, end).
+                 *
+                 * Unlike set() this can be called from several threads at
+                 * the same time, for instance with the nodes from different
+                 * buffers. The writes go straight into their slots without
+                 * any locking. If the vector has to grow, but its capacity
+                 * is large enough, the other writers go on. Only if the
+                 * data has to be moved, the thread doing this waits for
+                 * the other writers to finish. The vectors grow their
+                 * capacity geometrically, so this happens rarely even if
+                 * the ids are ascending. Call reserve() with the maximum
+                 * id (if you know it) to avoid it entirely.
+                 *
+                 * No two threads may write the same id at the same time
+                 * and you must not call set() or get() while any thread
+                 * is in this function.
+                 *
+                 * @tparam TIterator Iterator over std::pair<TId, TValue>
+                 *                   (or anything with first and second
+                 *                   members convertible to those types).
+                 */
+                template <typename TIterator>
+                void set_concurrently(TIterator begin, TIterator end) {
+                    if (begin == end) {
+                        return;
+                    }
+
+                    TId max_id = 0;
+                    for (auto it = begin; it != end; ++it) {
+                        max_id = std::max(max_id, static_cast<TId>(it->first));
+                    }
+
+                    const size_t min_size = static_cast<size_t>(max_id) + 1;
+                    while (!m_resize_guard.enter([this, min_size]() { return m_concurrent_size >= min_size; })) {
+                        m_resize_guard.grow([this, min_size]() {
+                            // Growing within the capacity doesn't move the
+                            // data, the other writers can go on with it.
+                            if (m_vector.size() < min_size && min_size <= m_vector.capacity()) {
+                                m_vector.resize(min_size);
+                            }
+                            m_concurrent_size = m_vector.size();
+                            return m_vector.size() >= min_size;
+                        }, [this, min_size]() {
+                            m_vector.resize(min_size);
+                            m_concurrent_size = m_vector.size();
+                        });
+                    }
+
+                    osmium::detail::ResizeGuard::Writer writer(m_resize_guard);
+
+                    // Another thread might change the size of the vector
+                    // (but not move the data) while we write.
+                    TValue* data = m_vector.data();
+                    for (auto it = begin; it != end; ++it) {
+                        data[it->first] = it->second;
+                    }
+                }
+
                 const TValue get(const TId id) const override final {
                     try {
                         const TValue& value = m_vector.at(id);
@@ -98,6 +170,16 @@ namespace osmium {
                 void clear() override final {
                     m_vector.clear();
                     m_vector.shrink_to_fit();
+                    m_concurrent_size = 0;
+                }
+
+                /**
+                 * Give the kernel a hint on how the memory of this map will
+                 * be accessed. Only available if the underlying vector is
+                 * mmap based.
+                 */
+                bool advise(osmium::detail::mmap_advice advice) {
+                    return m_vector.advise(advice);
                 }
 
             }; // class VectorBasedDenseMap
@@ -129,6 +211,10 @@ namespace osmium {
 
                 ~VectorBasedSparseMap() override final = default;
 
+                void reserve(const size_t size) override final {
+                    m_vector.reserve(size);
+                }
+
                 void set(const TId id, const TValue value) override final {
                     m_vector.push_back(element_type(id, value));
                 }
@@ -165,6 +251,15 @@ namespace osmium {
                     m_vector.shrink_to_fit();
                 }
 
+                /**
+                 * Give the kernel a hint on how the memory of this map will
+                 * be accessed. Only available if the underlying vector is
+                 * mmap based.
+                 */
+                bool advise(osmium::detail::mmap_advice advice) {
+                    return m_vector.advise(advice);
+                }
+
                 void sort() override final {
                     std::sort(m_vector.begin(), m_vector.end());
                 }
@@ -0,0 +1,549 @@
+#ifndef OSMIUM_INDEX_MULTIMAP_CSR_HPP
+#define OSMIUM_INDEX_MULTIMAP_CSR_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <osmium/index/detail/typed_mmap.hpp>
+#include <osmium/index/multimap.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace multimap {
+
+            namespace detail {
+
+                inline void append_varint(std::vector<unsigned char>& out, uint64_t value) {
+                    while (value >= 0x80) {
+                        out.push_back(static_cast<unsigned char>(value | 0x80));
+                        value >>= 7;
+                    }
+                    out.push_back(static_cast<unsigned char>(value));
+                }
+
+                inline uint64_t decode_varint(const unsigned char** data) {
+                    uint64_t value = 0;
+                    int shift = 0;
+                    while (**data & 0x80) {
+                        value |= static_cast<uint64_t>(**data & 0x7f) << shift;
+                        shift += 7;
+                        ++*data;
+                    }
+                    value |= static_cast<uint64_t>(**data) << shift;
+                    ++*data;
+                    return value;
+                }
+
+                struct csr_file_header {
+                    char magic[8];
+                    uint64_t num_keys;
+                    uint64_t num_values;
+                    uint64_t data_size;
+                    uint64_t id_size;
+                }; // struct csr_file_header
+
+                constexpr const char csr_magic[8] = { 'O', 'S', 'M', 'C', 'S', 'R', '1', '\0' };
+
+                inline size_t csr_padded(size_t size) {
+                    return (size + 7) & ~static_cast<size_t>(7);
+                }
+
+            } // namespace detail
+
+            /**
+             * Iterator over the values stored for one id in a CsrMultimap.
+             */
+            template <typename TId, typename TValue>
+            class CsrIterator {
+
+                typedef typename std::pair<TId, TValue> element_type;
+
+                const unsigned char* m_pos;
+                const unsigned char* m_next;
+                const unsigned char* m_end;
+                element_type m_element;
+
+                void decode(TValue previous) {
+                    m_next = m_pos;
+                    m_element.second = previous + static_cast<TValue>(detail::decode_varint(&m_next));
+                }
+
+            public:
+
+                CsrIterator(const unsigned char* begin, const unsigned char* end, const TId id) :
+                    m_pos(begin),
+                    m_next(begin),
+                    m_end(end),
+                    m_element(id, 0) {
+                    if (m_pos != m_end) {
+                        decode(0);
+                    }
+                }
+
+                CsrIterator& operator++() {
+                    m_pos = m_next;
+                    if (m_pos != m_end) {
+                        decode(m_element.second);
+                    }
+                    return *this;
+                }
+
+                CsrIterator<TId, TValue> operator++(int) {
+                    auto tmp(*this);
+                    operator++();
+                    return tmp;
+                }
+
+                bool operator==(const CsrIterator& rhs) const {
+                    return m_pos == rhs.m_pos;
+                }
+
+                bool operator!=(const CsrIterator& rhs) const {
+                    return ! operator==(rhs);
+                }
+
+                const element_type& operator*() const {
+                    return m_element;
+                }
+
+                const element_type* operator->() const {
+                    return &m_element;
+                }
+
+            }; // class CsrIterator
+
+            /**
+             * Compact build-once multimap from unsigned integers to
+             * unsigned integers in compressed sparse row (CSR) format.
+             * This is intended for large reverse indexes such as the
+             * node to way index filled by handler::ObjectRelations.
+             *
+             * Add all (id, value) pairs with set(), then call sort(). This
+             * sorts the pairs in parallel using the thread pool and builds
+             * the index: A sorted array of the distinct ids, an array of
+             * offsets into the value data (stored as 32 bit deltas to a
+             * 64 bit offset for each block of 64 ids), and the value data
+             * itself with the sorted values for each id delta encoded as
+             * varints. This usually needs a few bytes per pair instead of
+             * sizeof(std::pair<TId, TValue>).
+             *
+             * After sort() the index is read-only. It can be written to a
+             * file with dump() and mmap'ed from that file with the
+             * constructor taking a file descriptor.
+             */
+            template <typename TId, typename TValue>
+            class CsrMultimap : public Multimap<TId, TValue> {
+
+                static_assert(std::is_integral<TValue>::value && std::is_unsigned<TValue>::value,
+                              "TValue template parameter for class CsrMultimap must be unsigned integral type");
+
+                typedef typename std::pair<TId, TValue> element_type;
+
+                static constexpr size_t block_bits = 6;
+
+                // Pairs added with set() before the index is built.
+                std::vector<element_type> m_pairs;
+                bool m_built;
+
+                // Storage for an index built in memory.
+                std::vector<TId> m_key_storage;
+                std::vector<uint64_t> m_block_offset_storage;
+                std::vector<uint32_t> m_offset_delta_storage;
+                std::vector<unsigned char> m_data_storage;
+
+                // Storage for an index mmap'ed from a file.
+                char* m_mapping;
+                size_t m_mapping_size;
+
+                // View on the index in whichever storage.
+                const TId* m_keys;
+                const uint64_t* m_block_offsets;
+                const uint32_t* m_offset_deltas;
+                const unsigned char* m_data;
+                size_t m_num_keys;
+                size_t m_num_values;
+                size_t m_data_size;
+
+                struct encoded_chunk {
+                    std::vector<TId> keys;
+                    std::vector<uint64_t> offsets;
+                    std::vector<unsigned char> data;
+                }; // struct encoded_chunk
+
+                static size_t num_chunks(const size_t size) {
+                    const size_t min_chunk_size = 64 * 1024;
+                    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+                    return std::max(static_cast<size_t>(1), std::min(threads, size / min_chunk_size));
+                }
+
+                template <typename TFunc>
+                static void run_tasks(const size_t num, TFunc func) {
+                    if (num == 1) {
+                        func(0);
+                        return;
+                    }
+                    std::vector<std::future<void>> futures;
+                    for (size_t i = 0; i < num; ++i) {
+                        futures.push_back(osmium::thread::Pool::instance().submit([&func, i] { func(i); }));
+                    }
+                    for (auto& future : futures) {
+                        future.get();
+                    }
+                }
+
+                // Sort chunks in parallel, then merge them in parallel
+                // rounds.
+                void parallel_sort() {
+                    const size_t size = m_pairs.size();
+                    std::vector<size_t> bounds;
+                    const size_t chunks = num_chunks(size);
+                    for (size_t i = 0; i <= chunks; ++i) {
+                        bounds.push_back(size * i / chunks);
+                    }
+
+                    element_type* pairs = m_pairs.data();
+                    run_tasks(chunks, [pairs, &bounds](size_t i) {
+                        std::sort(pairs + bounds[i], pairs + bounds[i+1]);
+                    });
+
+                    while (bounds.size() > 2) {
+                        const size_t merges = (bounds.size() - 1) / 2;
+                        run_tasks(merges, [pairs, &bounds](size_t i) {
+                            std::inplace_merge(pairs + bounds[2*i], pairs + bounds[2*i+1], pairs + bounds[2*i+2]);
+                        });
+                        std::vector<size_t> new_bounds;
+                        for (size_t i = 0; i < bounds.size() - 1; i += 2) {
+                            new_bounds.push_back(bounds[i]);
+                        }
+                        new_bounds.push_back(size);
+                        bounds.swap(new_bounds);
+                    }
+                }
+
+                static void encode(const element_type* begin, const element_type* end, encoded_chunk& chunk) {
+                    while (begin != end) {
+                        const TId id = begin->first;
+                        chunk.keys.push_back(id);
+                        chunk.offsets.push_back(chunk.data.size());
+                        TValue previous = 0;
+                        for (; begin != end && begin->first == id; ++begin) {
+                            detail::append_varint(chunk.data, begin->second - previous);
+                            previous = begin->second;
+                        }
+                    }
+                }
+
+                void build() {
+                    parallel_sort();
+
+                    const size_t size = m_pairs.size();
+                    const size_t chunks = num_chunks(size);
+                    std::vector<size_t> bounds;
+                    bounds.push_back(0);
+                    for (size_t i = 1; i < chunks; ++i) {
+                        size_t n = std::max(bounds.back(), size * i / chunks);
+                        while (n > 0 && n < size && m_pairs[n].first == m_pairs[n-1].first) {
+                            ++n;
+                        }
+                        bounds.push_back(n);
+                    }
+                    bounds.push_back(size);
+
+                    std::vector<encoded_chunk> encoded(chunks);
+                    const element_type* pairs = m_pairs.data();
+                    run_tasks(chunks, [pairs, &bounds, &encoded](size_t i) {
+                        encode(pairs + bounds[i], pairs + bounds[i+1], encoded[i]);
+                    });
+
+                    m_num_values = size;
+                    std::vector<element_type>().swap(m_pairs);
+
+                    size_t num_keys = 0;
+                    size_t data_size = 0;
+                    for (const auto& chunk : encoded) {
+                        num_keys += chunk.keys.size();
+                        data_size += chunk.data.size();
+                    }
+
+                    m_key_storage.reserve(num_keys);
+                    m_data_storage.reserve(data_size);
+                    m_block_offset_storage.resize((num_keys >> block_bits) + 1);
+                    m_offset_delta_storage.resize(num_keys + 1);
+
+                    size_t n = 0;
+                    const auto add_offset = [this, &n](uint64_t offset) {
+                        if ((n & ((1 << block_bits) - 1)) == 0) {
+                            m_block_offset_storage[n >> block_bits] = offset;
+                        }
+                        const uint64_t delta = offset - m_block_offset_storage[n >> block_bits];
+                        if (delta > std::numeric_limits<uint32_t>::max()) {
+                            throw std::length_error("too many values for one id in CsrMultimap");
+                        }
+                        m_offset_delta_storage[n] = static_cast<uint32_t>(delta);
+                        ++n;
+                    };
+
+                    for (auto& chunk : encoded) {
+                        const uint64_t base = m_data_storage.size();
+                        m_key_storage.insert(m_key_storage.end(), chunk.keys.begin(), chunk.keys.end());
+                        for (const uint64_t offset : chunk.offsets) {
+                            add_offset(base + offset);
+                        }
+                        m_data_storage.insert(m_data_storage.end(), chunk.data.begin(), chunk.data.end());
+                        std::vector<TId>().swap(chunk.keys);
+                        std::vector<uint64_t>().swap(chunk.offsets);
+                        std::vector<unsigned char>().swap(chunk.data);
+                    }
+                    add_offset(m_data_storage.size());
+
+                    m_keys = m_key_storage.data();
+                    m_block_offsets = m_block_offset_storage.data();
+                    m_offset_deltas = m_offset_delta_storage.data();
+                    m_data = m_data_storage.data();
+                    m_num_keys = num_keys;
+                    m_data_size = m_data_storage.size();
+                    m_built = true;
+                }
+
+                uint64_t offset(const size_t n) const {
+                    return m_block_offsets[n >> block_bits] + m_offset_deltas[n];
+                }
+
+                void unmap() {
+                    if (m_mapping) {
+                        osmium::detail::typed_mmap<char>::unmap(m_mapping, m_mapping_size);
+                        m_mapping = nullptr;
+                        m_mapping_size = 0;
+                    }
+                }
+
+            public:
+
+                typedef CsrIterator<TId, TValue> iterator;
+                typedef CsrIterator<TId, TValue> const_iterator;
+
+                CsrMultimap() :
+                    m_pairs(),
+                    m_built(false),
+                    m_mapping(nullptr),
+                    m_mapping_size(0),
+                    m_keys(nullptr),
+                    m_block_offsets(nullptr),
+                    m_offset_deltas(nullptr),
+                    m_data(nullptr),
+                    m_num_keys(0),
+                    m_num_values(0),
+                    m_data_size(0) {
+                }
+
+                /**
+                 * Map an index written with dump() from a file.
+                 *
+                 * @exception std::runtime_error If the file is not a valid
+                 *            index for this TId type.
+                 */
+                explicit CsrMultimap(int fd) :
+                    CsrMultimap() {
+                    m_mapping_size = osmium::detail::typed_mmap<char>::file_size(fd);
+                    if (m_mapping_size < sizeof(detail::csr_file_header)) {
+                        throw std::runtime_error("invalid CSR index file");
+                    }
+                    m_mapping = osmium::detail::typed_mmap<char>::map(m_mapping_size, fd);
+
+                    detail::csr_file_header header;
+                    std::memcpy(&header, m_mapping, sizeof(header));
+                    const size_t keys_size = detail::csr_padded(header.num_keys * sizeof(TId));
+                    const size_t blocks_size = ((header.num_keys >> block_bits) + 1) * sizeof(uint64_t);
+                    const size_t deltas_size = detail::csr_padded((header.num_keys + 1) * sizeof(uint32_t));
+                    if (std::memcmp(header.magic, detail::csr_magic, sizeof(header.magic)) != 0 ||
+                        header.id_size != sizeof(TId) ||
+                        m_mapping_size != sizeof(header) + keys_size + blocks_size + deltas_size + header.data_size) {
+                        unmap();
+                        throw std::runtime_error("invalid CSR index file");
+                    }
+
+                    const char* pos = m_mapping + sizeof(header);
+                    m_keys = reinterpret_cast<const TId*>(pos);
+                    pos += keys_size;
+                    m_block_offsets = reinterpret_cast<const uint64_t*>(pos);
+                    pos += blocks_size;
+                    m_offset_deltas = reinterpret_cast<const uint32_t*>(pos);
+                    pos += deltas_size;
+                    m_data = reinterpret_cast<const unsigned char*>(pos);
+
+                    m_num_keys = header.num_keys;
+                    m_num_values = header.num_values;
+                    m_data_size = header.data_size;
+                    m_built = true;
+                }
+
+                ~CsrMultimap() noexcept override final {
+                    try {
+                        unmap();
+                    } catch (...) {
+                        // ignore errors in destructor
+                    }
+                }
+
+                /**
+                 * Add a pair. Can only be called before sort().
+                 *
+                 * @exception std::logic_error If the index was built already.
+                 */
+                void set(const TId id, const TValue value) override final {
+                    if (m_built) {
+                        throw std::logic_error("can not add to CsrMultimap after sort()");
+                    }
+                    m_pairs.emplace_back(id, value);
+                }
+
+                void reserve(const size_t size) {
+                    m_pairs.reserve(size);
+                }
+
+                /**
+                 * Build the index from all pairs added so far. Call this
+                 * after adding all pairs and before using get_all().
+                 */
+                void sort() override final {
+                    if (!m_built) {
+                        build();
+                    }
+                }
+
+                /**
+                 * Get all values for the id in ascending order. Only works
+                 * after sort().
+                 */
+                std::pair<iterator, iterator> get_all(const TId id) const {
+                    const TId* end = m_keys + m_num_keys;
+                    const TId* it = std::lower_bound(m_keys, end, id);
+                    if (it == end || *it != id) {
+                        return std::make_pair(iterator(m_data, m_data, id), iterator(m_data, m_data, id));
+                    }
+                    const size_t n = static_cast<size_t>(it - m_keys);
+                    const unsigned char* begin = m_data + offset(n);
+                    const unsigned char* last = m_data + offset(n + 1);
+                    return std::make_pair(iterator(begin, last, id), iterator(last, last, id));
+                }
+
+                /**
+                 * Number of distinct ids in the index.
+                 */
+                size_t num_keys() const {
+                    return m_num_keys;
+                }
+
+                size_t size() const override final {
+                    return m_built ? m_num_values : m_pairs.size();
+                }
+
+                size_t used_memory() const override final {
+                    if (!m_built) {
+                        return sizeof(element_type) * m_pairs.capacity();
+                    }
+                    return m_num_keys * sizeof(TId) +
+                           ((m_num_keys >> block_bits) + 1) * sizeof(uint64_t) +
+                           (m_num_keys + 1) * sizeof(uint32_t) +
+                           m_data_size;
+                }
+
+                void clear() override final {
+                    std::vector<element_type>().swap(m_pairs);
+                    std::vector<TId>().swap(m_key_storage);
+                    std::vector<uint64_t>().swap(m_block_offset_storage);
+                    std::vector<uint32_t>().swap(m_offset_delta_storage);
+                    std::vector<unsigned char>().swap(m_data_storage);
+                    unmap();
+                    m_keys = nullptr;
+                    m_block_offsets = nullptr;
+                    m_offset_deltas = nullptr;
+                    m_data = nullptr;
+                    m_num_keys = 0;
+                    m_num_values = 0;
+                    m_data_size = 0;
+                    m_built = false;
+                }
+
+                /**
+                 * Write the index to a file. It can later be used through
+                 * the constructor taking a file descriptor. Builds the
+                 * index if this wasn't done yet.
+                 */
+                void dump(const int fd) {
+                    sort();
+
+                    detail::csr_file_header header;
+                    std::memcpy(header.magic, detail::csr_magic, sizeof(header.magic));
+                    header.num_keys = m_num_keys;
+                    header.num_values = m_num_values;
+                    header.data_size = m_data_size;
+                    header.id_size = sizeof(TId);
+
+                    const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+                    const auto write_padded = [fd, &padding](const void* data, size_t size) {
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(data), size);
+                        osmium::io::detail::reliable_write(fd, padding, detail::csr_padded(size) - size);
+                    };
+
+                    write_padded(&header, sizeof(header));
+                    write_padded(m_keys, m_num_keys * sizeof(TId));
+                    write_padded(m_block_offsets, ((m_num_keys >> block_bits) + 1) * sizeof(uint64_t));
+                    write_padded(m_offset_deltas, (m_num_keys + 1) * sizeof(uint32_t));
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_data), m_data_size);
+                }
+
+            }; // class CsrMultimap
+
+        } // namespace multimap
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MULTIMAP_CSR_HPP
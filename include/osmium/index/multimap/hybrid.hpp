@@ -33,12 +33,15 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
 #include <cstddef>
+#include <functional>
+#include <queue>
 #include <utility>
+#include <vector>
 
 #include <osmium/index/multimap.hpp>
-#include <osmium/index/multimap/stl_vector.hpp>
-#include <osmium/index/multimap/stl_multimap.hpp>
+#include <osmium/io/detail/read_write.hpp>
 
 namespace osmium {
 
@@ -46,40 +49,113 @@ namespace osmium {
 
         namespace multimap {
 
-            template <typename TId, typename TValue>
-            class HybridIterator {
+            namespace detail {
+
+                template <typename TId, typename TValue>
+                struct hybrid_types {
+
+                    typedef typename std::pair<TId, TValue> element_type;
+                    typedef std::vector<element_type> run_type;
+
+                    static bool is_removed(const element_type& element) {
+                        return element.second == osmium::index::empty_value<TValue>();
+                    }
+
+                    static bool id_less(const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    }
 
-                typedef SparseMultimapMem<TId, TValue> main_map_type;
-                typedef StlMultimap<TId, TValue> extra_map_type;
+                    /**
+                     * Get the range of elements with the given id from a
+                     * sorted run.
+                     */
+                    template <typename TRun>
+                    static auto equal_range(TRun& run, const TId id) -> std::pair<decltype(run.data()), decltype(run.data())> {
+                        const element_type element {
+                            id,
+                            osmium::index::empty_value<TValue>()
+                        };
+                        return std::equal_range(run.data(), run.data() + run.size(), element, id_less);
+                    }
 
-                typedef typename std::pair<TId, TValue> element_type;
+                }; // struct hybrid_types
 
-                typename main_map_type::iterator m_begin_main;
-                typename main_map_type::iterator m_end_main;
-                typename extra_map_type::iterator m_begin_extra;
-                typename extra_map_type::iterator m_end_extra;
+            } // namespace detail
+
+            /**
+             * Iterator over all elements with the same id in all the runs
+             * of a Hybrid multimap. Removed elements are skipped.
+             */
+            template <typename TId, typename TValue>
+            class HybridIterator {
+
+                typedef detail::hybrid_types<TId, TValue> types;
+                typedef typename types::element_type element_type;
+                typedef typename types::run_type run_type;
+
+                const std::vector<run_type>* m_runs;
+                TId m_id;
+                size_t m_run;
+                const element_type* m_it;
+                const element_type* m_end;
+
+                // Move forward until we are on an element that was not
+                // removed or at the end of all runs.
+                void skip() {
+                    while (true) {
+                        while (m_it != m_end && types::is_removed(*m_it)) {
+                            ++m_it;
+                        }
+                        if (m_it != m_end) {
+                            return;
+                        }
+                        ++m_run;
+                        if (m_run >= m_runs->size()) {
+                            m_run = m_runs->size();
+                            m_it = nullptr;
+                            m_end = nullptr;
+                            return;
+                        }
+                        const auto range = types::equal_range((*m_runs)[m_run], m_id);
+                        m_it = range.first;
+                        m_end = range.second;
+                    }
+                }
 
             public:
 
-                explicit HybridIterator(typename main_map_type::iterator begin_main,
-                               typename main_map_type::iterator end_main,
-                               typename extra_map_type::iterator begin_extra,
-                               typename extra_map_type::iterator end_extra) :
-                    m_begin_main(begin_main),
-                    m_end_main(end_main),
-                    m_begin_extra(begin_extra),
-                    m_end_extra(end_extra) {
+                /**
+                 * Create iterator for the first element with the given
+                 * id in the runs.
+                 */
+                explicit HybridIterator(const std::vector<run_type>& runs, const TId id) :
+                    m_runs(&runs),
+                    m_id(id),
+                    m_run(0),
+                    m_it(nullptr),
+                    m_end(nullptr) {
+                    if (!runs.empty()) {
+                        const auto range = types::equal_range(runs.front(), id);
+                        m_it = range.first;
+                        m_end = range.second;
+                    }
+                    skip();
+                }
+
+                /**
+                 * Create end iterator.
+                 */
+                explicit HybridIterator(const std::vector<run_type>& runs) :
+                    m_runs(&runs),
+                    m_id(0),
+                    m_run(runs.size()),
+                    m_it(nullptr),
+                    m_end(nullptr) {
                 }
 
                 HybridIterator& operator++() {
-                    if (m_begin_main == m_end_main) {
-                        ++m_begin_extra;
-                    } else {
-                        ++m_begin_main;
-                        while (m_begin_main != m_end_main && m_begin_main->second == osmium::index::empty_value<TValue>()) { // ignore removed elements
-                            ++m_begin_main;
-                        }
-                    }
+                    ++m_it;
+                    skip();
                     return *this;
                 }
 
@@ -90,105 +166,245 @@ namespace osmium {
                 }
 
                 bool operator==(const HybridIterator& rhs) const {
-                    return m_begin_main == rhs.m_begin_main &&
-                           m_end_main   == rhs.m_end_main &&
-                           m_begin_extra == rhs.m_begin_extra &&
-                           m_end_extra   == rhs.m_end_extra;
+                    return m_run == rhs.m_run &&
+                           m_it  == rhs.m_it;
                 }
 
                 bool operator!=(const HybridIterator& rhs) const {
                     return ! operator==(rhs);
                 }
 
-                const element_type& operator*() {
-                    if (m_begin_main == m_end_main) {
-                        return *m_begin_extra;
-                    } else {
-                        return *m_begin_main;
-                    }
+                const element_type& operator*() const {
+                    return *m_it;
                 }
 
-                const element_type* operator->() {
-                    return &operator*();
+                const element_type* operator->() const {
+                    return m_it;
                 }
 
-            };
-
+            }; // class HybridIterator
+
+            /**
+             * Multimap for indexes that are created in bulk and updated
+             * later. It is organized like a log-structured merge tree:
+             *
+             * The bulk data (added with unsorted_set() and sorted with
+             * sort()) is kept in one large sorted vector, the main run.
+             * Elements added later with set() are collected in a small
+             * write buffer. When it is full, it is sorted and becomes a
+             * new run. Runs of similar size are merged, so that there are
+             * only O(log n) runs at any time, each one at least twice as
+             * large as the next. remove() only marks elements as removed
+             * (tombstones), they are dropped when runs are merged.
+             * consolidate() merges everything into the main run.
+             *
+             * All this means that updates cost amortized sequential work
+             * with no per-element allocation.
+             */
             template <typename TId, typename TValue>
             class Hybrid : public Multimap<TId, TValue> {
 
-                typedef SparseMultimapMem<TId, TValue> main_map_type;
-                typedef StlMultimap<TId, TValue> extra_map_type;
+                typedef detail::hybrid_types<TId, TValue> types;
+                typedef typename types::element_type element_type;
+                typedef typename types::run_type run_type;
+
+                typedef std::pair<const element_type*, const element_type*> range_type;
+
+                // Runs are merged when the larger one is less than
+                // merge_factor times as large as the smaller one.
+                static constexpr size_t merge_factor = 2;
+
+                // m_runs[0] is the main run. Runs get smaller towards
+                // the back.
+                std::vector<run_type> m_runs;
+                run_type m_buffer;
+                size_t m_buffer_size;
+
+                /**
+                 * Merge the sorted ranges into out, dropping all removed
+                 * elements.
+                 */
+                static void merge(std::vector<range_type>& ranges, run_type& out) {
+                    size_t size = 0;
+                    for (const auto& range : ranges) {
+                        size += range.second - range.first;
+                    }
+                    out.reserve(size);
 
-                main_map_type m_main;
-                extra_map_type m_extra;
+                    const auto greater = [](const range_type& a, const range_type& b) {
+                        return *b.first < *a.first;
+                    };
+                    std::priority_queue<range_type, std::vector<range_type>, decltype(greater)> queue(greater);
+
+                    const auto push = [&queue](range_type range) {
+                        while (range.first != range.second && types::is_removed(*range.first)) {
+                            ++range.first;
+                        }
+                        if (range.first != range.second) {
+                            queue.push(range);
+                        }
+                    };
+
+                    for (const auto& range : ranges) {
+                        push(range);
+                    }
+
+                    while (!queue.empty()) {
+                        range_type range = queue.top();
+                        queue.pop();
+                        out.push_back(*range.first);
+                        ++range.first;
+                        push(range);
+                    }
+                }
+
+                static range_type full_range(const run_type& run) {
+                    return range_type(run.data(), run.data() + run.size());
+                }
+
+                void flush_buffer() {
+                    if (m_buffer.empty()) {
+                        return;
+                    }
+
+                    std::sort(m_buffer.begin(), m_buffer.end());
+                    m_runs.emplace_back();
+                    m_runs.back().swap(m_buffer);
+
+                    while (m_runs.size() > 2 && m_runs[m_runs.size() - 2].size() < merge_factor * m_runs.back().size()) {
+                        std::vector<range_type> ranges {
+                            full_range(m_runs[m_runs.size() - 2]),
+                            full_range(m_runs.back())
+                        };
+                        run_type merged;
+                        merge(ranges, merged);
+                        m_runs.pop_back();
+                        m_runs.back().swap(merged);
+                    }
+                }
 
             public:
 
                 typedef HybridIterator<TId, TValue> iterator;
                 typedef const HybridIterator<TId, TValue> const_iterator;
 
-                Hybrid() :
-                    m_main(),
-                    m_extra() {
+                /**
+                 * @param buffer_size Number of elements collected in the
+                 *                    write buffer before they are sorted
+                 *                    into a run.
+                 */
+                explicit Hybrid(const size_t buffer_size = 64 * 1024) :
+                    m_runs(1),
+                    m_buffer(),
+                    m_buffer_size(buffer_size) {
                 }
 
                 size_t size() const override final {
-                    return m_main.size() + m_extra.size();
+                    size_t size = m_buffer.size();
+                    for (const auto& run : m_runs) {
+                        size += run.size();
+                    }
+                    return size;
                 }
 
                 size_t used_memory() const override final {
-                    return m_main.used_memory() + m_extra.used_memory();
+                    size_t size = m_buffer.capacity();
+                    for (const auto& run : m_runs) {
+                        size += run.capacity();
+                    }
+                    return sizeof(element_type) * size;
+                }
+
+                /**
+                 * Number of sorted runs including the main run.
+                 */
+                size_t num_runs() const {
+                    return m_runs.size();
                 }
 
                 void reserve(const size_t size) {
-                    m_main.reserve(size);
+                    m_runs.front().reserve(size);
                 }
 
+                /**
+                 * Add element to the main run. Call sort() after adding
+                 * all elements this way and before using the index.
+                 */
                 void unsorted_set(const TId id, const TValue value) {
-                    m_main.set(id, value);
+                    m_runs.front().emplace_back(id, value);
                 }
 
                 void set(const TId id, const TValue value) override final {
-                    m_extra.set(id, value);
+                    if (m_buffer.capacity() == 0) {
+                        m_buffer.reserve(m_buffer_size);
+                    }
+                    m_buffer.emplace_back(id, value);
+                    if (m_buffer.size() >= m_buffer_size) {
+                        flush_buffer();
+                    }
                 }
 
                 std::pair<iterator, iterator> get_all(const TId id) {
-                    auto result_main = m_main.get_all(id);
-                    auto result_extra = m_extra.get_all(id);
-                    return std::make_pair(iterator(result_main.first, result_main.second, result_extra.first, result_extra.second),
-                                          iterator(result_main.second, result_main.second, result_extra.second, result_extra.second));
+                    flush_buffer();
+                    return std::make_pair(iterator(m_runs, id), iterator(m_runs));
                 }
 
                 void remove(const TId id, const TValue value) {
-                    m_main.remove(id, value);
-                    m_extra.remove(id, value);
+                    for (auto& element : m_buffer) {
+                        if (element.first == id && element.second == value) {
+                            element.second = osmium::index::empty_value<TValue>();
+                            return;
+                        }
+                    }
+                    for (auto& run : m_runs) {
+                        const auto range = types::equal_range(run, id);
+                        for (auto it = range.first; it != range.second; ++it) {
+                            if (it->second == value) {
+                                it->second = osmium::index::empty_value<TValue>();
+                                return;
+                            }
+                        }
+                    }
                 }
 
+                /**
+                 * Merge all runs and the write buffer into the main run.
+                 * Removed elements are dropped.
+                 */
                 void consolidate() {
-                    m_main.erase_removed();
-                    for (const auto& element : m_extra) {
-                        m_main.set(element.first, element.second);
+                    std::sort(m_buffer.begin(), m_buffer.end());
+                    std::vector<range_type> ranges;
+                    ranges.reserve(m_runs.size() + 1);
+                    for (const auto& run : m_runs) {
+                        ranges.push_back(full_range(run));
                     }
-                    m_extra.clear();
-                    m_main.sort();
+                    ranges.push_back(full_range(m_buffer));
+
+                    run_type merged;
+                    merge(ranges, merged);
+
+                    m_runs.resize(1);
+                    m_runs.front().swap(merged);
+                    run_type().swap(m_buffer);
                 }
 
                 void dump_as_list(int fd) {
                     consolidate();
-                    m_main.dump_as_list(fd);
+                    const run_type& main = m_runs.front();
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(main.data()), sizeof(element_type) * main.size());
                 }
 
                 void clear() override final {
-                    m_main.clear();
-                    m_extra.clear();
+                    m_runs.resize(1);
+                    run_type().swap(m_runs.front());
+                    run_type().swap(m_buffer);
                 }
 
                 void sort() override final {
-                    m_main.sort();
+                    std::sort(m_runs.front().begin(), m_runs.front().end());
                 }
 
-            }; // Hybrid
+            }; // class Hybrid
 
         } // namespace multimap
 
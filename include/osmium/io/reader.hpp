@@ -121,12 +121,17 @@ namespace osmium {
             std::unique_ptr<osmium::io::detail::InputFormat> m_input;
             osmium::thread::Queue<std::string> m_input_queue {};
 
-            std::unique_ptr<osmium::io::Decompressor> m_decompressor;
+            // Set by execute() while m_decompressor is initialized, so it
+            // must come before it.
+            int m_childpid {0};
 
-            osmium::thread::CheckedTask<InputThread> m_input_task;
+            std::unique_ptr<osmium::io::Decompressor> m_decompressor;
 
+            // Must be initialized before m_input_task starts the thread
+            // using it.
             std::atomic<bool> m_input_done {false};
-            int m_childpid {0};
+
+            osmium::thread::CheckedTask<InputThread> m_input_task;
 
             /**
              * Fork and execute the given command in the child.
@@ -0,0 +1,218 @@
+#ifndef OSMIUM_MEMORY_ARENA_HPP
+#define OSMIUM_MEMORY_ARENA_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * Monotonic memory arena. Memory is handed out from large blocks
+         * and never given back individually. Calling reset() makes all of
+         * it available again at once while keeping the blocks, so an
+         * arena reused for many similar tasks stops calling malloc after
+         * the first few.
+         *
+         * Objects allocated from the arena are not destroyed by it, they
+         * must be destroyed before reset() is called.
+         */
+        class Arena {
+
+            struct block {
+                std::unique_ptr<unsigned char[]> data;
+                size_t size;
+            }; // struct block
+
+            std::vector<block> m_blocks;
+
+            // index of the block we are currently allocating from
+            size_t m_current;
+
+            // bytes used in the current block
+            size_t m_used;
+
+            size_t m_block_size;
+
+            unsigned char* allocate_in_current(size_t size, size_t alignment) noexcept {
+                if (m_current >= m_blocks.size()) {
+                    return nullptr;
+                }
+                const block& b = m_blocks[m_current];
+                const uintptr_t start = reinterpret_cast<uintptr_t>(b.data.get()) + m_used;
+                const size_t padding = (alignment - start % alignment) % alignment;
+                if (m_used + padding + size > b.size) {
+                    return nullptr;
+                }
+                m_used += padding + size;
+                return reinterpret_cast<unsigned char*>(start + padding);
+            }
+
+        public:
+
+            static constexpr size_t default_block_size = 64 * 1024;
+
+            explicit Arena(size_t block_size = default_block_size) :
+                m_blocks(),
+                m_current(0),
+                m_used(0),
+                m_block_size(block_size) {
+            }
+
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            // ArenaAllocators point to their arena, so it can't be moved
+            // either.
+            Arena(Arena&&) = delete;
+            Arena& operator=(Arena&&) = delete;
+
+            ~Arena() = default;
+
+            /**
+             * Allocate size bytes aligned to alignment (which must be a
+             * power of two not larger than the alignment guaranteed by
+             * operator new).
+             */
+            void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+                unsigned char* ptr = allocate_in_current(size, alignment);
+                while (!ptr) {
+                    if (m_current + 1 < m_blocks.size()) {
+                        ++m_current;
+                    } else {
+                        const size_t block_size = std::max(m_block_size, size + alignment);
+                        m_blocks.push_back(block{std::unique_ptr<unsigned char[]>(new unsigned char[block_size]), block_size});
+                        m_current = m_blocks.size() - 1;
+                    }
+                    m_used = 0;
+                    ptr = allocate_in_current(size, alignment);
+                }
+                return ptr;
+            }
+
+            /**
+             * Make all memory available again. Blocks are kept for reuse.
+             */
+            void reset() noexcept {
+                m_current = 0;
+                m_used = 0;
+            }
+
+            /**
+             * Give all memory back to the system.
+             */
+            void release() noexcept {
+                m_blocks.clear();
+                reset();
+            }
+
+            /// The number of bytes in all blocks.
+            size_t capacity() const noexcept {
+                size_t sum = 0;
+                for (const auto& b : m_blocks) {
+                    sum += b.size;
+                }
+                return sum;
+            }
+
+        }; // class Arena
+
+        /**
+         * Standard allocator allocating from an Arena. Deallocation is
+         * a no-op, the memory is reclaimed when the arena is reset.
+         * Containers using this must be emptied (including their
+         * capacity) before the arena is reset.
+         */
+        template <typename T>
+        class ArenaAllocator {
+
+            template <typename U>
+            friend class ArenaAllocator;
+
+            Arena* m_arena;
+
+        public:
+
+            typedef T value_type;
+
+            // Not explicit, so containers can be constructed from an arena.
+            ArenaAllocator(Arena& arena) noexcept :
+                m_arena(&arena) {
+            }
+
+            template <typename U>
+            ArenaAllocator(const ArenaAllocator<U>& other) noexcept :
+                m_arena(other.m_arena) {
+            }
+
+            T* allocate(size_t n) {
+                return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(T*, size_t) noexcept {
+            }
+
+            Arena& arena() const noexcept {
+                return *m_arena;
+            }
+
+            // Needed for older standard libraries without full allocator_traits support.
+            template <typename U>
+            struct rebind {
+                typedef ArenaAllocator<U> other;
+            };
+
+        }; // class ArenaAllocator
+
+        template <typename T, typename U>
+        inline bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) noexcept {
+            return &lhs.arena() == &rhs.arena();
+        }
+
+        template <typename T, typename U>
+        inline bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) noexcept {
+            return !(lhs == rhs);
+        }
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_ARENA_HPP
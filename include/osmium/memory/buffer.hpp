@@ -483,23 +483,27 @@ namespace osmium {
              */
             template <class TCallbackClass>
             void purge_removed(TCallbackClass* callback) {
-                iterator it_write = begin();
+                // The write position can't be an iterator, because the
+                // iterator would look at the (stale) data behind the items
+                // already moved when it is incremented.
+                unsigned char* write = data();
 
                 iterator next;
                 for (iterator it_read = begin(); it_read != end(); it_read = next) {
                     next = std::next(it_read);
                     if (!it_read->removed()) {
-                        if (it_read != it_write) {
+                        const size_t size = it_read->padded_size();
+                        if (it_read->data() != write) {
                             size_t old_offset = it_read->data() - data();
-                            size_t new_offset = it_write->data() - data();
+                            size_t new_offset = write - data();
                             callback->moving_in_buffer(old_offset, new_offset);
-                            std::memmove(it_write->data(), it_read->data(), it_read->padded_size());
+                            std::memmove(write, it_read->data(), size);
                         }
-                        ++it_write;
+                        write += size;
                     }
                 }
 
-                m_written = it_write->data() - data();
+                m_written = write - data();
                 m_committed = m_written;
             }
 
@@ -35,13 +35,30 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/detail/typed_mmap.hpp>
+#include <osmium/index/bloom_filter.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/item.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp> // IWYU pragma: keep
@@ -143,10 +160,22 @@ namespace osmium {
                  *          relation and false otherwise
                  */
                 bool find_and_add_object(const osmium::OSMObject& object) {
+                    // Most objects are not members of any relation we are
+                    // interested in. Sort them out with a single memory
+                    // access. The few false positives of the Bloom filter
+                    // are sorted out by the exact (but slower) id set.
+                    const auto id = static_cast<osmium::unsigned_object_id_type>(object.id());
+                    if (!m_collector.member_filter(object.type()).maybe_contains(id) ||
+                        !m_collector.member_ids(object.type()).contains(id)) {
+                        return false;
+                    }
+
                     auto& mmv = m_collector.member_meta(object.type());
                     auto range = std::equal_range(mmv.begin(), mmv.end(), MemberMeta(object.id()));
 
-                    if (range.first == range.second) {
+                    if (std::all_of(range.first, range.second, [](const MemberMeta& mm) {
+                        return mm.removed();
+                    })) {
                         // nothing found
                         return false;
                     }
@@ -161,8 +190,13 @@ namespace osmium {
                         }
                     }
 
+                    m_collector.possibly_purge_removed_members();
+
                     for (auto it = range.first; it != range.second; ++it) {
                         MemberMeta& member_meta = *it;
+                        if (member_meta.removed()) {
+                            continue;
+                        }
                         assert(member_meta.member_id() == object.id());
                         assert(member_meta.relation_pos() < m_collector.m_relations.size());
                         RelationMeta& relation_meta = m_collector.m_relations[member_meta.relation_pos()];
@@ -172,12 +206,16 @@ namespace osmium {
                         relation_meta.got_one_member();
                         if (relation_meta.has_all_members()) {
                             const size_t relation_offset = member_meta.relation_pos();
+                            m_collector.page_in_members(relation_meta);
                             m_collector.complete_relation(relation_meta);
                             m_collector.m_relations[relation_offset] = RelationMeta();
                             m_collector.possibly_purge_removed_members();
                         }
                     }
 
+                    // Only safe now that we are done with the range.
+                    m_collector.possibly_compact_member_meta();
+
                     return true;
                 }
 
@@ -235,7 +273,68 @@ namespace osmium {
              */
             std::vector<MemberMeta> m_member_meta[3];
 
-            int m_count_complete = 0;
+            typedef osmium::index::BloomFilter<osmium::unsigned_object_id_type> member_filter_type;
+
+            /**
+             * One Bloom filter each for nodes, ways, and relations with the
+             * ids of all members. Used to quickly find out whether an
+             * object can be a member at all.
+             */
+            member_filter_type m_member_filter[3];
+
+            typedef osmium::index::IdSet<osmium::unsigned_object_id_type> id_set_type;
+
+            /**
+             * One set each for nodes, ways, and relations containing the
+             * ids of all members. Only checked for objects that got past
+             * the Bloom filter.
+             */
+            id_set_type m_member_ids[3];
+
+            /// Number of entries in each of the m_member_meta vectors marked as removed.
+            size_t m_removed_member_meta[3] = {0, 0, 0};
+
+            /// Bytes in m_members_buffer used by members marked as removed.
+            size_t m_removed_bytes = 0;
+
+            /**
+             * If the members buffer gets larger than this, members are
+             * spilled to disk. 0 means no limit.
+             */
+            size_t m_members_memory_limit = 0;
+
+            /// File members are spilled to (-1 if it wasn't needed yet).
+            int m_spill_fd = -1;
+
+            /// Current size of the spill file.
+            size_t m_spill_size = 0;
+
+            /// Bytes of the spill file read back into the members buffer.
+            size_t m_paged_in_size = 0;
+
+            /// Bytes spilled over the lifetime of the collector.
+            size_t m_spilled_total = 0;
+
+            /// Spilled members are written to the spill file in chunks of this size.
+            static constexpr size_t spill_chunk_size = 1024 * 1024;
+
+            /**
+             * The buffer_offset of a MemberMeta has this bit set if the
+             * member was spilled to disk. The other bits are the offset
+             * in the spill file then.
+             */
+            static constexpr size_t spilled_flag = static_cast<size_t>(1) << (sizeof(size_t) * 8 - 1);
+
+            /**
+             * Removed members are only purged from the members buffer if
+             * they take up at least this many bytes...
+             */
+            static constexpr size_t min_purge_size = 1024 * 1024;
+
+            /**
+             * ...and at least this percentage of the members buffer.
+             */
+            static constexpr size_t min_purge_percent = 50;
 
             typedef std::function<void(const osmium::memory::Buffer&)> callback_func_type;
             callback_func_type m_callback;
@@ -252,7 +351,15 @@ namespace osmium {
                 m_relations_buffer(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes),
                 m_members_buffer(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes),
                 m_relations(),
-                m_member_meta() {
+                m_member_meta(),
+                m_member_filter(),
+                m_member_ids() {
+            }
+
+            ~Collector() {
+                if (m_spill_fd >= 0) {
+                    ::close(m_spill_fd);
+                }
             }
 
         protected:
@@ -261,6 +368,14 @@ namespace osmium {
                 return m_member_meta[static_cast<uint16_t>(type) - 1];
             }
 
+            const member_filter_type& member_filter(const item_type type) const {
+                return m_member_filter[static_cast<uint16_t>(type) - 1];
+            }
+
+            const id_set_type& member_ids(const item_type type) const {
+                return m_member_ids[static_cast<uint16_t>(type) - 1];
+            }
+
             callback_func_type callback() {
                 return m_callback;
             }
@@ -366,6 +481,20 @@ namespace osmium {
                 return m_members_buffer.get<osmium::OSMObject>(offset);
             }
 
+            /**
+             * Mark the member at the given offset in the members buffer as
+             * removed. Call this once the member is not needed any more.
+             * Its memory will be reclaimed when the members buffer is
+             * purged.
+             */
+            void remove_member(size_t offset) {
+                osmium::OSMObject& member = get_member(offset);
+                if (!member.removed()) {
+                    member.removed(true);
+                    m_removed_bytes += member.padded_size();
+                }
+            }
+
             /**
              * Tell the Collector that you are interested in this relation
              * and want it kept until all members have been assembled and
@@ -413,6 +542,23 @@ namespace osmium {
                 std::sort(m_member_meta[0].begin(), m_member_meta[0].end());
                 std::sort(m_member_meta[1].begin(), m_member_meta[1].end());
                 std::sort(m_member_meta[2].begin(), m_member_meta[2].end());
+                build_member_filters();
+            }
+
+            void build_member_filters() {
+                for (int i = 0; i < 3; ++i) {
+                    std::vector<osmium::unsigned_object_id_type> ids;
+                    ids.reserve(m_member_meta[i].size());
+                    m_member_filter[i].reset(m_member_meta[i].size());
+                    for (const auto& mm : m_member_meta[i]) {
+                        const auto id = static_cast<osmium::unsigned_object_id_type>(mm.member_id());
+                        m_member_filter[i].insert(id);
+                        ids.push_back(id);
+                    }
+                    m_member_ids[i].clear();
+                    m_member_ids[i].insert(ids.cbegin(), ids.cend());
+                    m_member_ids[i].optimize();
+                }
             }
 
         public:
@@ -478,6 +624,112 @@ namespace osmium {
                 source.close();
             }
 
+            /**
+             * Write the state collected in the first pass (the relations
+             * buffer, the relation infos, and the sorted member infos) to
+             * a cache file. A later run on the same input can then call
+             * load_relations() instead of read_relations() and go
+             * straight to the second pass.
+             *
+             * The cache is keyed by the identity (device, inode, size, and
+             * modification time) of the input file, the type of the
+             * collector, and the version of the cache format. Call this
+             * after read_relations() and before the second pass.
+             *
+             * The cache is written to a temporary file next to it and
+             * renamed into place, so a concurrent load_relations() or a
+             * crash never leaves a half-written cache behind.
+             *
+             * @param cache_filename Name of the cache file. It is
+             *                       replaced if it exists.
+             * @param input_filename Name of the input file the relations
+             *                       were read from.
+             * @returns false if the input is not a regular file and
+             *          nothing was written.
+             * @exception std::system_error If the cache could not be written.
+             */
+            bool save_relations(const std::string& cache_filename, const std::string& input_filename) const {
+                cache_header header;
+                if (!make_cache_header(header, input_filename)) {
+                    return false;
+                }
+                header.relations_buffer_size = m_relations_buffer.committed();
+                header.num_relations = m_relations.size();
+                for (int i = 0; i < 3; ++i) {
+                    header.num_member_meta[i] = m_member_meta[i].size();
+                }
+
+                const std::string tmp_filename = cache_filename + ".tmp." + std::to_string(::getpid());
+                const int fd = osmium::io::detail::open_for_writing(tmp_filename, osmium::io::overwrite::allow);
+                try {
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(&header), sizeof(header));
+                    osmium::io::detail::reliable_write(fd, m_relations_buffer.data(), m_relations_buffer.committed());
+                    write_vector(fd, m_relations);
+                    for (int i = 0; i < 3; ++i) {
+                        write_vector(fd, m_member_meta[i]);
+                    }
+                } catch (...) {
+                    ::close(fd);
+                    ::unlink(tmp_filename.c_str());
+                    throw;
+                }
+                if (::close(fd) != 0) {
+                    const int error = errno;
+                    ::unlink(tmp_filename.c_str());
+                    throw std::system_error(error, std::system_category(), "Close failed");
+                }
+                if (::rename(tmp_filename.c_str(), cache_filename.c_str()) != 0) {
+                    const int error = errno;
+                    ::unlink(tmp_filename.c_str());
+                    throw std::system_error(error, std::system_category(), "Rename of cache file failed");
+                }
+                return true;
+            }
+
+            /**
+             * Restore the first pass state from a cache file written by
+             * save_relations(). The cache file is memory mapped and its
+             * contents are copied into the collector.
+             *
+             * @param cache_filename Name of the cache file.
+             * @param input_filename Name of the input file.
+             * @returns true if the cache was loaded, false if it doesn't
+             *          exist or doesn't match the input file or the type
+             *          of this collector. In that case read_relations()
+             *          must be called as usual.
+             */
+            bool load_relations(const std::string& cache_filename, const std::string& input_filename) {
+                cache_header expected;
+                if (!make_cache_header(expected, input_filename)) {
+                    return false;
+                }
+
+                const int fd = ::open(cache_filename.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    return false;
+                }
+
+                struct stat s;
+                if (::fstat(fd, &s) != 0 || static_cast<size_t>(s.st_size) < sizeof(cache_header)) {
+                    ::close(fd);
+                    return false;
+                }
+                const size_t size = static_cast<size_t>(s.st_size);
+
+                unsigned char* data = osmium::detail::typed_mmap<unsigned char>::map(size, fd);
+                ::close(fd);
+
+                bool loaded = false;
+                try {
+                    loaded = load_from_cache(data, size, expected);
+                } catch (...) {
+                    osmium::detail::typed_mmap<unsigned char>::unmap(data, size);
+                    throw;
+                }
+                osmium::detail::typed_mmap<unsigned char>::unmap(data, size);
+                return loaded;
+            }
+
             void moving_in_buffer(size_t old_offset, size_t new_offset) {
                 const osmium::OSMObject& object = m_members_buffer.get<osmium::OSMObject>(old_offset);
                 auto& mmv = member_meta(object.type());
@@ -488,23 +740,314 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Mark an entry in the member meta vector for the given type as
+             * removed. Call this instead of erasing it from the vector,
+             * which would be linear in the size of the vector. Removed
+             * entries are ignored and cleaned up later.
+             */
+            void remove_member_meta(const item_type type, MemberMeta& member_meta) {
+                assert(!member_meta.removed());
+                member_meta.remove();
+                ++m_removed_member_meta[static_cast<uint16_t>(type) - 1];
+            }
+
+            /**
+             * Remove the entries marked as removed from the member meta
+             * vectors, but only from those where they make up at least
+             * half of the vector. This keeps the cost of removing entries
+             * linear overall.
+             *
+             * Invalidates iterators into the vectors.
+             */
+            void possibly_compact_member_meta() {
+                for (int i = 0; i < 3; ++i) {
+                    auto& mmv = m_member_meta[i];
+                    if (m_removed_member_meta[i] == 0 || m_removed_member_meta[i] * 2 < mmv.size()) {
+                        continue;
+                    }
+                    mmv.erase(std::remove_if(mmv.begin(), mmv.end(), [](const MemberMeta& mm) {
+                        return mm.removed();
+                    }), mmv.end());
+                    m_removed_member_meta[i] = 0;
+                }
+            }
+
+            /**
+             * Set the maximum size of the members buffer in bytes. If it
+             * grows beyond that, the oldest members (belonging to the
+             * relations that have been waiting the longest) are written
+             * to a temporary file until the buffer is half that size.
+             * They are read back in when their relation is complete.
+             * The default of 0 means no limit.
+             */
+            void members_memory_limit(size_t limit) {
+                m_members_memory_limit = limit;
+            }
+
+            /**
+             * Bytes of member data spilled to disk so far.
+             */
+            size_t spilled_size() const {
+                return m_spilled_total;
+            }
+
+            /**
+             * Current size of the spill file. The file is truncated once
+             * all members spilled to it were read back.
+             */
+            size_t spill_file_size() const {
+                return m_spill_size;
+            }
+
             /**
              * Decide whether to purge removed members and then do it.
              *
-             * Currently the purging is done every thousand calls.
-             * This could probably be improved upon.
+             * The members buffer is purged when the removed members take
+             * up a large part of it or when it has grown beyond the
+             * memory limit (in which case members are spilled to disk
+             * first).
              */
             void possibly_purge_removed_members() {
-                ++m_count_complete;
-                if (m_count_complete > 10000) { // XXX
-                    const size_t size_before = m_members_buffer.committed();
-                    m_members_buffer.purge_removed(this);
-                    const size_t size_after = m_members_buffer.committed();
-                    double percent = size_before - size_after;
-                    percent /= size_before;
-                    percent *= 100;
-                    std::cerr << "PURGE (size before=" << size_before << " after=" << size_after << " purged=" << (size_before - size_after) << " / " << static_cast<int>(percent) << "%)\n";
-                    m_count_complete = 0;
+                const size_t size_before = m_members_buffer.committed();
+                const bool fragmented = m_removed_bytes >= min_purge_size &&
+                                        m_removed_bytes * 100 >= size_before * min_purge_percent;
+                const bool too_large = m_members_memory_limit > 0 && size_before > m_members_memory_limit;
+
+                if (!fragmented && !too_large) {
+                    return;
+                }
+
+                if (too_large && size_before - m_removed_bytes > m_members_memory_limit / 2) {
+                    spill_members();
+                }
+
+                m_members_buffer.purge_removed(this);
+                m_removed_bytes = 0;
+            }
+
+        private:
+
+            /**
+             * Header of the cache file written by save_relations(). It is
+             * followed by the relations buffer, the RelationMeta vector,
+             * and the three MemberMeta vectors.
+             */
+            struct cache_header {
+                char magic[8];
+                uint64_t format_version;
+                uint64_t input_device;
+                uint64_t input_inode;
+                uint64_t input_size;
+                uint64_t input_mtime;
+                uint64_t input_mtime_nsec;
+                uint64_t collector_type;
+                uint64_t sizeof_relation_meta;
+                uint64_t sizeof_member_meta;
+                uint64_t relations_buffer_size;
+                uint64_t num_relations;
+                uint64_t num_member_meta[3];
+            }; // struct cache_header
+
+            static constexpr const char* cache_magic = "OSMRELC";
+
+            // Increment whenever the layout of the header, RelationMeta,
+            // or MemberMeta changes.
+            static constexpr uint64_t cache_format_version = 1;
+
+            static bool make_cache_header(cache_header& header, const std::string& input_filename) {
+                struct stat s;
+                if (input_filename.empty() || input_filename == "-" ||
+                    ::stat(input_filename.c_str(), &s) != 0 || !S_ISREG(s.st_mode)) {
+                    return false;
+                }
+
+                std::memset(&header, 0, sizeof(header));
+                std::memcpy(header.magic, cache_magic, sizeof(header.magic));
+                header.format_version = cache_format_version;
+                header.input_device = static_cast<uint64_t>(s.st_dev);
+                header.input_inode = static_cast<uint64_t>(s.st_ino);
+                header.input_size = static_cast<uint64_t>(s.st_size);
+                header.input_mtime = static_cast<uint64_t>(s.st_mtime);
+#ifdef __APPLE__
+                header.input_mtime_nsec = static_cast<uint64_t>(s.st_mtimespec.tv_nsec);
+#else
+                header.input_mtime_nsec = static_cast<uint64_t>(s.st_mtim.tv_nsec);
+#endif
+                header.collector_type = std::hash<std::string>()(typeid(TCollector).name());
+                header.sizeof_relation_meta = sizeof(RelationMeta);
+                header.sizeof_member_meta = sizeof(MemberMeta);
+                return true;
+            }
+
+            template <class T>
+            static void write_vector(int fd, const std::vector<T>& vector) {
+                if (!vector.empty()) {
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(vector.data()), sizeof(T) * vector.size());
+                }
+            }
+
+            template <class T>
+            static const unsigned char* read_vector(const unsigned char* data, std::vector<T>& vector, size_t count) {
+                const T* first = reinterpret_cast<const T*>(data);
+                vector.assign(first, first + count);
+                return data + sizeof(T) * count;
+            }
+
+            bool load_from_cache(const unsigned char* data, size_t size, const cache_header& expected) {
+                cache_header header;
+                std::memcpy(&header, data, sizeof(header));
+                if (std::memcmp(&header, &expected, offsetof(cache_header, relations_buffer_size)) != 0) {
+                    return false;
+                }
+
+                const uint64_t num_members = header.num_member_meta[0] + header.num_member_meta[1] + header.num_member_meta[2];
+                if (header.relations_buffer_size % osmium::memory::align_bytes != 0 ||
+                    size != sizeof(header) + header.relations_buffer_size +
+                            header.num_relations * sizeof(RelationMeta) +
+                            num_members * sizeof(MemberMeta)) {
+                    return false;
+                }
+
+                const unsigned char* ptr = data + sizeof(header);
+                const size_t buffer_size = static_cast<size_t>(header.relations_buffer_size);
+                const size_t min_size = initial_buffer_size;
+                osmium::memory::Buffer buffer(std::max(buffer_size, min_size), osmium::memory::Buffer::auto_grow::yes);
+                if (buffer_size > 0) {
+                    std::memcpy(buffer.reserve_space(buffer_size), ptr, buffer_size);
+                    buffer.commit();
+                }
+                ptr += buffer_size;
+                using std::swap;
+                swap(m_relations_buffer, buffer);
+
+                ptr = read_vector(ptr, m_relations, static_cast<size_t>(header.num_relations));
+                for (int i = 0; i < 3; ++i) {
+                    ptr = read_vector(ptr, m_member_meta[i], static_cast<size_t>(header.num_member_meta[i]));
+                }
+                assert(ptr == data + size);
+
+                build_member_filters();
+                return true;
+            }
+
+            /**
+             * Write members from the front of the members buffer to the
+             * spill file until the members left take up at most half of
+             * the memory limit. The spilled members are marked as removed
+             * in the buffer. They are staged and written in chunks of
+             * spill_chunk_size bytes.
+             */
+            void spill_members() {
+                if (m_spill_fd < 0) {
+                    m_spill_fd = osmium::detail::create_tmp_file();
+                }
+
+                std::vector<unsigned char> chunk;
+                chunk.reserve(spill_chunk_size);
+
+                size_t live_size = m_members_buffer.committed() - m_removed_bytes;
+                for (auto it = m_members_buffer.begin(); it != m_members_buffer.end() && live_size > m_members_memory_limit / 2; ++it) {
+                    if (it->removed()) {
+                        continue;
+                    }
+                    osmium::OSMObject& object = static_cast<osmium::OSMObject&>(*it);
+                    const size_t size = object.padded_size();
+                    if (!chunk.empty() && chunk.size() + size > spill_chunk_size) {
+                        osmium::io::detail::reliable_write(m_spill_fd, chunk.data(), chunk.size());
+                        chunk.clear();
+                    }
+
+                    auto& mmv = member_meta(object.type());
+                    auto range = std::equal_range(mmv.begin(), mmv.end(), osmium::relations::MemberMeta(object.id()));
+                    for (auto mm = range.first; mm != range.second; ++mm) {
+                        mm->buffer_offset(spilled_flag | m_spill_size);
+                    }
+
+                    chunk.insert(chunk.end(), object.data(), object.data() + size);
+                    m_spill_size += size;
+                    m_spilled_total += size;
+                    object.removed(true);
+                    m_removed_bytes += size;
+                    live_size -= size;
+                }
+
+                if (!chunk.empty()) {
+                    osmium::io::detail::reliable_write(m_spill_fd, chunk.data(), chunk.size());
+                }
+            }
+
+            /**
+             * Truncate the spill file once everything in it was read
+             * back, so a long run doesn't keep growing it.
+             */
+            void possibly_truncate_spill_file() {
+                if (m_paged_in_size < m_spill_size) {
+                    return;
+                }
+                if (::ftruncate(m_spill_fd, 0) != 0) {
+                    throw std::system_error(errno, std::system_category(), "Truncating spill file failed");
+                }
+                if (::lseek(m_spill_fd, 0, SEEK_SET) != 0) {
+                    throw std::system_error(errno, std::system_category(), "Seek in spill file failed");
+                }
+                m_spill_size = 0;
+                m_paged_in_size = 0;
+            }
+
+            void read_spilled(unsigned char* data, size_t size, size_t offset) const {
+                while (size > 0) {
+                    const ssize_t nread = ::pread(m_spill_fd, data, size, static_cast<off_t>(offset));
+                    if (nread < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        throw std::system_error(errno, std::system_category(), "Read from spill file failed");
+                    }
+                    if (nread == 0) {
+                        throw std::runtime_error("Unexpected end of spill file");
+                    }
+                    data += nread;
+                    size -= static_cast<size_t>(nread);
+                    offset += static_cast<size_t>(nread);
+                }
+            }
+
+        public:
+
+            /**
+             * Make sure all members of the relation are in the members
+             * buffer by reading back those that were spilled to disk.
+             */
+            void page_in_members(const RelationMeta& relation_meta) {
+                if (m_spill_size == 0) {
+                    return;
+                }
+                for (const auto& member : get_relation(relation_meta).members()) {
+                    if (member.ref() == 0) {
+                        continue;
+                    }
+                    auto& mmv = member_meta(member.type());
+                    auto range = std::equal_range(mmv.begin(), mmv.end(), osmium::relations::MemberMeta(member.ref()));
+                    if (range.first == range.second || !(range.first->buffer_offset() & spilled_flag)) {
+                        continue;
+                    }
+
+                    const size_t spill_offset = range.first->buffer_offset() & ~spilled_flag;
+                    typename std::aligned_storage<sizeof(osmium::memory::Item), alignof(osmium::memory::Item)>::type header;
+                    read_spilled(reinterpret_cast<unsigned char*>(&header), sizeof(header), spill_offset);
+                    const size_t size = reinterpret_cast<const osmium::memory::Item*>(&header)->padded_size();
+
+                    const size_t offset = m_members_buffer.committed();
+                    read_spilled(m_members_buffer.reserve_space(size), size, spill_offset);
+                    m_members_buffer.commit();
+
+                    for (auto it = range.first; it != range.second; ++it) {
+                        it->buffer_offset(offset);
+                    }
+
+                    m_paged_in_size += size;
+                    possibly_truncate_spill_file();
                 }
             }
 
@@ -74,6 +74,12 @@ namespace osmium {
              */
             size_t m_buffer_offset { 0 };
 
+            /**
+             * Set when the relation this member is a part of was completed.
+             * Removed entries stay in the vector until it is compacted.
+             */
+            bool m_removed { false };
+
         public:
 
             /**
@@ -107,6 +113,14 @@ namespace osmium {
                 m_buffer_offset = offset;
             }
 
+            bool removed() const {
+                return m_removed;
+            }
+
+            void remove() {
+                m_removed = true;
+            }
+
         }; // class MemberMeta
 
         /**
@@ -120,7 +134,7 @@ namespace osmium {
 
         template <typename TChar, typename TTraits>
         inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const MemberMeta& mm) {
-            out << "MemberMeta(member_id=" << mm.member_id() << " relation_pos=" << mm.relation_pos() << " member_pos=" << mm.member_pos() << " buffer_offset=" << mm.buffer_offset() << ")";
+            out << "MemberMeta(member_id=" << mm.member_id() << " relation_pos=" << mm.relation_pos() << " member_pos=" << mm.member_pos() << " buffer_offset=" << mm.buffer_offset() << (mm.removed() ? " removed" : "") << ")";
             return out;
         }
 
@@ -151,6 +151,10 @@ namespace osmium {
                 m_done = true;
             }
 
+            int num_threads() const {
+                return m_num_threads;
+            }
+
             size_t queue_size() const {
                 return m_work_queue.size();
             }
@@ -0,0 +1,431 @@
+#ifndef OSMIUM_UTIL_DOUBLE_HPP
+#define OSMIUM_UTIL_DOUBLE_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013,2014 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace osmium {
+
+    namespace util {
+
+        namespace detail {
+
+            /**
+             * Floating point number f * 2^e with a 64 bit significand
+             * used by the Grisu3 algorithm.
+             */
+            struct diy_fp {
+
+                uint64_t f;
+                int e;
+
+                constexpr diy_fp(uint64_t significand, int exponent) noexcept :
+                    f(significand),
+                    e(exponent) {
+                }
+
+                /// x - y, both must have the same exponent and x >= y.
+                static diy_fp sub(const diy_fp& x, const diy_fp& y) noexcept {
+                    assert(x.e == y.e && x.f >= y.f);
+                    return diy_fp(x.f - y.f, x.e);
+                }
+
+                /// x * y rounded to the upper 64 bits of the product.
+                static diy_fp mul(const diy_fp& x, const diy_fp& y) noexcept {
+                    const uint64_t mask = 0xffffffffu;
+                    const uint64_t a = x.f >> 32;
+                    const uint64_t b = x.f & mask;
+                    const uint64_t c = y.f >> 32;
+                    const uint64_t d = y.f & mask;
+
+                    const uint64_t ac = a * c;
+                    const uint64_t bc = b * c;
+                    const uint64_t ad = a * d;
+                    const uint64_t bd = b * d;
+
+                    const uint64_t tmp = (bd >> 32) + (ad & mask) + (bc & mask) + (uint64_t(1) << 31);
+                    return diy_fp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64);
+                }
+
+                static diy_fp normalize(diy_fp x) noexcept {
+                    assert(x.f != 0);
+                    while ((x.f >> 63) == 0) {
+                        x.f <<= 1;
+                        --x.e;
+                    }
+                    return x;
+                }
+
+                static diy_fp normalize_to(const diy_fp& x, int e) noexcept {
+                    assert(x.e >= e);
+                    return diy_fp(x.f << (x.e - e), e);
+                }
+
+            }; // struct diy_fp
+
+            /**
+             * Approximation f * 2^e of 10^k.
+             */
+            struct cached_power {
+                uint64_t f;
+                int e;
+                int k;
+            }; // struct cached_power
+
+            // Range for the binary exponent of the scaled value, the
+            // digits are generated from 64 bit integers and 32 bit
+            // integers for the integral part.
+            constexpr int grisu_alpha = -60;
+            constexpr int grisu_gamma = -32;
+
+            /**
+             * Get a cached power c = 10^k so that the product of c and
+             * a number with binary exponent e has a binary exponent in
+             * [grisu_alpha, grisu_gamma].
+             */
+            inline cached_power get_cached_power(int e) noexcept {
+                static const cached_power powers[] = {
+                    { 0xFA8FD5A0081C0288ULL, -1220, -348 },
+                    { 0xBAAEE17FA23EBF76ULL, -1193, -340 },
+                    { 0x8B16FB203055AC76ULL, -1166, -332 },
+                    { 0xCF42894A5DCE35EAULL, -1140, -324 },
+                    { 0x9A6BB0AA55653B2DULL, -1113, -316 },
+                    { 0xE61ACF033D1A45DFULL, -1087, -308 },
+                    { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+                    { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+                    { 0xBE5691EF416BD60CULL, -1007, -284 },
+                    { 0x8DD01FAD907FFC3CULL,  -980, -276 },
+                    { 0xD3515C2831559A83ULL,  -954, -268 },
+                    { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },
+                    { 0xEA9C227723EE8BCBULL,  -901, -252 },
+                    { 0xAECC49914078536DULL,  -874, -244 },
+                    { 0x823C12795DB6CE57ULL,  -847, -236 },
+                    { 0xC21094364DFB5637ULL,  -821, -228 },
+                    { 0x9096EA6F3848984FULL,  -794, -220 },
+                    { 0xD77485CB25823AC7ULL,  -768, -212 },
+                    { 0xA086CFCD97BF97F4ULL,  -741, -204 },
+                    { 0xEF340A98172AACE5ULL,  -715, -196 },
+                    { 0xB23867FB2A35B28EULL,  -688, -188 },
+                    { 0x84C8D4DFD2C63F3BULL,  -661, -180 },
+                    { 0xC5DD44271AD3CDBAULL,  -635, -172 },
+                    { 0x936B9FCEBB25C996ULL,  -608, -164 },
+                    { 0xDBAC6C247D62A584ULL,  -582, -156 },
+                    { 0xA3AB66580D5FDAF6ULL,  -555, -148 },
+                    { 0xF3E2F893DEC3F126ULL,  -529, -140 },
+                    { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },
+                    { 0x87625F056C7C4A8BULL,  -475, -124 },
+                    { 0xC9BCFF6034C13053ULL,  -449, -116 },
+                    { 0x964E858C91BA2655ULL,  -422, -108 },
+                    { 0xDFF9772470297EBDULL,  -396, -100 },
+                    { 0xA6DFBD9FB8E5B88FULL,  -369,  -92 },
+                    { 0xF8A95FCF88747D94ULL,  -343,  -84 },
+                    { 0xB94470938FA89BCFULL,  -316,  -76 },
+                    { 0x8A08F0F8BF0F156BULL,  -289,  -68 },
+                    { 0xCDB02555653131B6ULL,  -263,  -60 },
+                    { 0x993FE2C6D07B7FACULL,  -236,  -52 },
+                    { 0xE45C10C42A2B3B06ULL,  -210,  -44 },
+                    { 0xAA242499697392D3ULL,  -183,  -36 },
+                    { 0xFD87B5F28300CA0EULL,  -157,  -28 },
+                    { 0xBCE5086492111AEBULL,  -130,  -20 },
+                    { 0x8CBCCC096F5088CCULL,  -103,  -12 },
+                    { 0xD1B71758E219652CULL,   -77,   -4 },
+                    { 0x9C40000000000000ULL,   -50,    4 },
+                    { 0xE8D4A51000000000ULL,   -24,   12 },
+                    { 0xAD78EBC5AC620000ULL,     3,   20 },
+                    { 0x813F3978F8940984ULL,    30,   28 },
+                    { 0xC097CE7BC90715B3ULL,    56,   36 },
+                    { 0x8F7E32CE7BEA5C70ULL,    83,   44 },
+                    { 0xD5D238A4ABE98068ULL,   109,   52 },
+                    { 0x9F4F2726179A2245ULL,   136,   60 },
+                    { 0xED63A231D4C4FB27ULL,   162,   68 },
+                    { 0xB0DE65388CC8ADA8ULL,   189,   76 },
+                    { 0x83C7088E1AAB65DBULL,   216,   84 },
+                    { 0xC45D1DF942711D9AULL,   242,   92 },
+                    { 0x924D692CA61BE758ULL,   269,  100 },
+                    { 0xDA01EE641A708DEAULL,   295,  108 },
+                    { 0xA26DA3999AEF774AULL,   322,  116 },
+                    { 0xF209787BB47D6B85ULL,   348,  124 },
+                    { 0xB454E4A179DD1877ULL,   375,  132 },
+                    { 0x865B86925B9BC5C2ULL,   402,  140 },
+                    { 0xC83553C5C8965D3DULL,   428,  148 },
+                    { 0x952AB45CFA97A0B3ULL,   455,  156 },
+                    { 0xDE469FBD99A05FE3ULL,   481,  164 },
+                    { 0xA59BC234DB398C25ULL,   508,  172 },
+                    { 0xF6C69A72A3989F5CULL,   534,  180 },
+                    { 0xB7DCBF5354E9BECEULL,   561,  188 },
+                    { 0x88FCF317F22241E2ULL,   588,  196 },
+                    { 0xCC20CE9BD35C78A5ULL,   614,  204 },
+                    { 0x98165AF37B2153DFULL,   641,  212 },
+                    { 0xE2A0B5DC971F303AULL,   667,  220 },
+                    { 0xA8D9D1535CE3B396ULL,   694,  228 },
+                    { 0xFB9B7CD9A4A7443CULL,   720,  236 },
+                    { 0xBB764C4CA7A44410ULL,   747,  244 },
+                    { 0x8BAB8EEFB6409C1AULL,   774,  252 },
+                    { 0xD01FEF10A657842CULL,   800,  260 },
+                    { 0x9B10A4E5E9913129ULL,   827,  268 },
+                    { 0xE7109BFBA19C0C9DULL,   853,  276 },
+                    { 0xAC2820D9623BF429ULL,   880,  284 },
+                    { 0x80444B5E7AA7CF85ULL,   907,  292 },
+                    { 0xBF21E44003ACDD2DULL,   933,  300 },
+                    { 0x8E679C2F5E44FF8FULL,   960,  308 },
+                    { 0xD433179D9C8CB841ULL,   986,  316 },
+                    { 0x9E19DB92B4E31BA9ULL,  1013,  324 },
+                    { 0xEB96BF6EBADF77D9ULL,  1039,  332 },
+                    { 0xAF87023B9BF0EE6BULL,  1066,  340 }
+                };
+
+                constexpr int min_decimal_exponent = -348;
+                constexpr int decimal_exponent_step = 8;
+
+                // k = ceil((alpha - e - 1) * log10(2))
+                const int f = grisu_alpha - e - 1;
+                const int k = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);
+                const int index = (-min_decimal_exponent + k + (decimal_exponent_step - 1)) / decimal_exponent_step;
+                assert(index >= 0 && static_cast<size_t>(index) < sizeof(powers) / sizeof(powers[0]));
+
+                const cached_power& cached = powers[index];
+                assert(grisu_alpha <= cached.e + e + 64 && cached.e + e + 64 <= grisu_gamma);
+                return cached;
+            }
+
+            /**
+             * Move the last digit in buffer down as long as the number
+             * stays inside the rounding interval and gets closer to w.
+             * Returns false if, because of the imprecision of the scaled
+             * values, it can't be decided which digit is closest or if
+             * the digits are inside the interval at all.
+             */
+            inline bool round_weed(char* buffer, int length, uint64_t distance_too_high_w, uint64_t unsafe_interval, uint64_t rest, uint64_t ten_kappa, uint64_t unit) noexcept {
+                const uint64_t small_distance = distance_too_high_w - unit;
+                const uint64_t big_distance = distance_too_high_w + unit;
+
+                while (rest < small_distance &&
+                       unsafe_interval - rest >= ten_kappa &&
+                       (rest + ten_kappa < small_distance ||
+                        small_distance - rest >= rest + ten_kappa - small_distance)) {
+                    --buffer[length - 1];
+                    rest += ten_kappa;
+                }
+
+                if (rest < big_distance &&
+                    unsafe_interval - rest >= ten_kappa &&
+                    (rest + ten_kappa < big_distance ||
+                     big_distance - rest > rest + ten_kappa - big_distance)) {
+                    return false;
+                }
+
+                return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+            }
+
+            /**
+             * Generate the shortest digits of a number in the interval
+             * (low, high) that is closest to w. All three have the same
+             * exponent in [grisu_alpha, grisu_gamma] and are off by up
+             * to one unit.
+             */
+            inline bool digit_gen(char* buffer, int& length, int& decimal_exponent, const diy_fp& low, const diy_fp& w, const diy_fp& high) noexcept {
+                uint64_t unit = 1;
+                const diy_fp too_low(low.f - unit, low.e);
+                const diy_fp too_high(high.f + unit, high.e);
+                uint64_t unsafe_interval = diy_fp::sub(too_high, too_low).f;
+
+                const int shift = -w.e;
+                const uint64_t one = uint64_t(1) << shift;
+
+                uint32_t integrals = static_cast<uint32_t>(too_high.f >> shift);
+                uint64_t fractionals = too_high.f & (one - 1);
+
+                uint32_t divisor = 1000000000;
+                int kappa = 10;
+                while (kappa > 1 && integrals < divisor) {
+                    divisor /= 10;
+                    --kappa;
+                }
+
+                while (kappa > 0) {
+                    buffer[length++] = static_cast<char>('0' + integrals / divisor);
+                    integrals %= divisor;
+                    --kappa;
+
+                    const uint64_t rest = (static_cast<uint64_t>(integrals) << shift) + fractionals;
+                    if (rest < unsafe_interval) {
+                        decimal_exponent += kappa;
+                        return round_weed(buffer, length, diy_fp::sub(too_high, w).f, unsafe_interval, rest, static_cast<uint64_t>(divisor) << shift, unit);
+                    }
+                    divisor /= 10;
+                }
+
+                for (;;) {
+                    fractionals *= 10;
+                    unit *= 10;
+                    unsafe_interval *= 10;
+                    buffer[length++] = static_cast<char>('0' + (fractionals >> shift));
+                    fractionals &= one - 1;
+                    --decimal_exponent;
+                    if (fractionals < unsafe_interval) {
+                        return round_weed(buffer, length, diy_fp::sub(too_high, w).f * unit, unsafe_interval, fractionals, one, unit);
+                    }
+                }
+            }
+
+            /**
+             * Write the shortest decimal digits of the finite, positive
+             * value that read back as the same double into buffer (at
+             * least 18 characters). If there are several, the one
+             * closest to the value is used. The value is
+             * digits * 10^decimal_exponent then.
+             *
+             * This is the Grisu3 algorithm by Florian Loitsch ("Printing
+             * Floating-Point Numbers Quickly and Accurately with
+             * Integers", 2010). It works on 64 bit integers only and
+             * gives up (returning false) on about 0.5% of all doubles
+             * where that isn't precise enough.
+             */
+            inline bool grisu3(char* buffer, int& length, int& decimal_exponent, double value) noexcept {
+                assert(std::isfinite(value) && value > 0);
+
+                constexpr int significand_size = 52;
+                constexpr int exponent_bias = 1075;
+                constexpr uint64_t hidden_bit = uint64_t(1) << significand_size;
+
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                const int biased_exponent = static_cast<int>(bits >> significand_size);
+                const uint64_t fraction = bits & (hidden_bit - 1);
+
+                const diy_fp v = biased_exponent == 0 ? diy_fp(fraction, 1 - exponent_bias)
+                                                      : diy_fp(fraction + hidden_bit, biased_exponent - exponent_bias);
+
+                // The boundaries are half way to the neighbouring doubles.
+                // The lower one is closer if value is a power of two.
+                const bool lower_boundary_is_closer = fraction == 0 && biased_exponent > 1;
+                const diy_fp m_plus = diy_fp::normalize(diy_fp(2 * v.f + 1, v.e - 1));
+                const diy_fp m_minus = diy_fp::normalize_to(lower_boundary_is_closer ? diy_fp(4 * v.f - 1, v.e - 2)
+                                                                                     : diy_fp(2 * v.f - 1, v.e - 1), m_plus.e);
+
+                const cached_power cached = get_cached_power(m_plus.e);
+                const diy_fp c(cached.f, cached.e);
+
+                length = 0;
+                decimal_exponent = -cached.k;
+                return digit_gen(buffer, length, decimal_exponent,
+                                 diy_fp::mul(m_minus, c),
+                                 diy_fp::mul(diy_fp::normalize(v), c),
+                                 diy_fp::mul(m_plus, c));
+            }
+
+        } // namespace detail
+
+        /**
+         * Append double to string using as few digits as possible
+         * while still being able to read back exactly the same value.
+         *
+         * The format follows printf("%g") with the precision set to the
+         * number of digits (but at least 15): Numbers are written in
+         * exponential notation only if they are very small or large.
+         */
+        inline void double2string(std::string& s, double value) {
+            if (!std::isfinite(value)) {
+                char buffer[8];
+                const int length = std::snprintf(buffer, sizeof(buffer), "%g", value);
+                s.append(buffer, static_cast<size_t>(length));
+                return;
+            }
+
+            if (std::signbit(value)) {
+                s += '-';
+                value = -value;
+            }
+
+            if (value == 0) {
+                s += '0';
+                return;
+            }
+
+            char digits[32];
+            int length;
+            int decimal_exponent;
+            if (!detail::grisu3(digits, length, decimal_exponent, value)) {
+                // Any number with up to 15 digits survives a round trip
+                // through a double, so the first match is the shortest.
+                char buffer[32];
+                int buffer_length = 0;
+                for (int precision = 15; precision <= 17; ++precision) {
+                    buffer_length = std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+                    if (std::strtod(buffer, nullptr) == value) {
+                        break;
+                    }
+                }
+                s.append(buffer, static_cast<size_t>(buffer_length));
+                return;
+            }
+
+            // exponent in d.ddd notation
+            const int exponent = length + decimal_exponent - 1;
+            const int precision = length > 15 ? length : 15;
+
+            if (exponent < -4 || exponent >= precision) {
+                s += digits[0];
+                if (length > 1) {
+                    s += '.';
+                    s.append(digits + 1, static_cast<size_t>(length - 1));
+                }
+                char buffer[8];
+                const int exponent_length = std::snprintf(buffer, sizeof(buffer), "e%+03d", exponent);
+                s.append(buffer, static_cast<size_t>(exponent_length));
+            } else if (exponent < 0) {
+                s += "0.";
+                s.append(static_cast<size_t>(-exponent - 1), '0');
+                s.append(digits, static_cast<size_t>(length));
+            } else if (exponent + 1 >= length) {
+                s.append(digits, static_cast<size_t>(length));
+                s.append(static_cast<size_t>(exponent + 1 - length), '0');
+            } else {
+                s.append(digits, static_cast<size_t>(exponent + 1));
+                s += '.';
+                s.append(digits + exponent + 1, static_cast<size_t>(length - exponent - 1));
+            }
+        }
+
+    } // namespace util
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_DOUBLE_HPP
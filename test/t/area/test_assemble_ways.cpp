@@ -0,0 +1,59 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include <osmium/area/assemble_ways.hpp>
+#include <osmium/area/assembler.hpp>
+#include <osmium/osm/area.hpp>
+
+#include "../basic/helper.hpp"
+
+typedef std::vector<std::pair<osmium::object_id_type, osmium::Location>> node_list_type;
+
+static std::vector<osmium::object_id_type> area_ids(const osmium::memory::Buffer& buffer) {
+    std::vector<osmium::object_id_type> ids;
+    for (auto it = buffer.cbegin<osmium::Area>(); it != buffer.cend<osmium::Area>(); ++it) {
+        ids.push_back(it->id());
+    }
+    return ids;
+}
+
+TEST_CASE("Assemble closed ways in buffer") {
+
+    osmium::memory::Buffer in_buffer(1024 * 1024);
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        const double x = static_cast<double>(id % 100);
+        const double y = static_cast<double>(id / 100);
+        node_list_type nodes {
+            { id * 10,     osmium::Location(x,       y      ) },
+            { id * 10 + 1, osmium::Location(x + 0.5, y      ) },
+            { id * 10 + 2, osmium::Location(x + 0.5, y + 0.5) },
+            { id * 10 + 3, osmium::Location(x,       y + 0.5) }
+        };
+        if (id % 3 != 0) { // every third way is not closed
+            nodes.push_back(nodes.front());
+        }
+        buffer_add_way(in_buffer, "foo", {{"building", "yes"}}, nodes).id(id);
+        if (id % 10 == 0) {
+            buffer_add_node(in_buffer, "foo", {}, osmium::Location(x, y)).id(id);
+        }
+    }
+
+    osmium::area::Assembler::config_type config;
+
+    osmium::memory::Buffer serial(1024);
+    osmium::area::Assembler assembler(config);
+    osmium::area::assemble_closed_ways(assembler, in_buffer, serial);
+
+    const std::vector<osmium::object_id_type> ids = area_ids(serial);
+    REQUIRE(ids.size() == 667);
+    REQUIRE(ids.front() == 2); // area id of way 1
+    REQUIRE(ids.back() == 2000);
+    for (auto it = serial.cbegin<osmium::Area>(); it != serial.cend<osmium::Area>(); ++it) {
+        REQUIRE(it->num_rings() == std::make_pair(1, 0));
+    }
+
+    osmium::memory::Buffer parallel(1024);
+    osmium::area::assemble_closed_ways_parallel<osmium::area::Assembler>(config, in_buffer, parallel);
+    REQUIRE(area_ids(parallel) == ids);
+}
@@ -0,0 +1,121 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/osm/area.hpp>
+
+#include "../basic/helper.hpp"
+
+typedef std::vector<std::pair<osmium::object_id_type, osmium::Location>> node_list_type;
+
+static node_list_type square(osmium::object_id_type first_id, int32_t x, int32_t y, int32_t size) {
+    return node_list_type {
+        { first_id,     osmium::Location(x,        y       ) },
+        { first_id + 1, osmium::Location(x + size, y       ) },
+        { first_id + 2, osmium::Location(x + size, y + size) },
+        { first_id + 3, osmium::Location(x,        y + size) },
+        { first_id,     osmium::Location(x,        y       ) }
+    };
+}
+
+TEST_CASE("Assembler with many inner rings in several outer rings") {
+
+    osmium::memory::Buffer in_buffer(1024 * 1024);
+    std::vector<size_t> offsets;
+    std::vector<std::tuple<char, osmium::object_id_type, const char*>> members;
+    osmium::object_id_type way_id = 1;
+
+    auto add_ring = [&](int32_t x, int32_t y, int32_t size, const char* role) {
+        offsets.push_back(in_buffer.committed());
+        buffer_add_way(in_buffer, "foo", {}, square(way_id * 10, x, y, size)).id(way_id);
+        members.emplace_back('w', way_id, role);
+        ++way_id;
+    };
+
+    for (int32_t outer = 0; outer < 3; ++outer) {
+        const int32_t x = outer * 2000;
+        add_ring(x, 0, 1000, "outer");
+        for (int32_t i = 0; i < 4; ++i) {
+            for (int32_t j = 0; j < 4; ++j) {
+                add_ring(x + 100 + i * 200, 100 + j * 200, 100, "inner");
+            }
+        }
+    }
+
+    // island in one of the inner rings
+    add_ring(2120, 120, 50, "outer");
+
+    const osmium::Relation& relation = buffer_add_relation(in_buffer, "foo", {{"type", "multipolygon"}}, members);
+
+    osmium::area::Assembler::config_type config;
+    osmium::area::Assembler assembler(config);
+    osmium::memory::Buffer out_buffer(1024 * 1024);
+    assembler(relation, offsets, in_buffer, out_buffer);
+
+    const osmium::Area& area = out_buffer.get<osmium::Area>(0);
+    REQUIRE(area.num_rings() == std::make_pair(4, 48));
+
+    std::vector<int> inner_per_outer;
+    for (auto it = area.cbegin(); it != area.cend(); ++it) {
+        if (it->type() == osmium::item_type::outer_ring) {
+            inner_per_outer.push_back(0);
+        } else if (it->type() == osmium::item_type::inner_ring) {
+            ++inner_per_outer.back();
+        }
+    }
+    std::sort(inner_per_outer.begin(), inner_per_outer.end());
+    REQUIRE(inner_per_outer == std::vector<int>({0, 16, 16, 16}));
+}
+
+TEST_CASE("Assembler with closed ways that are not simple rings") {
+
+    osmium::area::Assembler::config_type config;
+    osmium::area::Assembler assembler(config);
+    osmium::memory::Buffer in_buffer(1024 * 1024);
+    osmium::memory::Buffer out_buffer(1024 * 1024);
+
+    SECTION("self-intersecting way") {
+        const osmium::Way& way = buffer_add_way(in_buffer, "foo", {{"building", "yes"}}, {
+            { 1, osmium::Location(0, 0) },
+            { 2, osmium::Location(10, 10) },
+            { 3, osmium::Location(10, 0) },
+            { 4, osmium::Location(0, 10) },
+            { 1, osmium::Location(0, 0) }
+        });
+        assembler(way, out_buffer);
+
+        const osmium::Area& area = out_buffer.get<osmium::Area>(0);
+        REQUIRE(area.num_rings() == std::make_pair(0, 0));
+    }
+
+    SECTION("outer ring made of two ways") {
+        std::vector<size_t> offsets;
+        offsets.push_back(in_buffer.committed());
+        buffer_add_way(in_buffer, "foo", {}, {
+            { 1, osmium::Location(0, 0) },
+            { 2, osmium::Location(10, 0) },
+            { 3, osmium::Location(10, 10) }
+        }).id(1);
+        offsets.push_back(in_buffer.committed());
+        buffer_add_way(in_buffer, "foo", {}, {
+            { 3, osmium::Location(10, 10) },
+            { 4, osmium::Location(0, 10) },
+            { 1, osmium::Location(0, 0) }
+        }).id(2);
+        offsets.push_back(in_buffer.committed());
+        buffer_add_way(in_buffer, "foo", {}, square(10, 2, 2, 2)).id(3);
+        const osmium::Relation& relation = buffer_add_relation(in_buffer, "foo", {{"type", "multipolygon"}, {"landuse", "forest"}}, {
+            std::make_tuple('w', 1, "outer"),
+            std::make_tuple('w', 2, "outer"),
+            std::make_tuple('w', 3, "inner")
+        });
+        assembler(relation, offsets, in_buffer, out_buffer);
+
+        const osmium::Area& area = out_buffer.get<osmium::Area>(0);
+        REQUIRE(area.num_rings() == std::make_pair(1, 1));
+    }
+}
@@ -0,0 +1,251 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_collector.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/visitor.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../basic/helper.hpp"
+
+typedef std::vector<std::pair<osmium::object_id_type, osmium::Location>> node_list_type;
+
+static node_list_type square(osmium::object_id_type first_id, double x, double y) {
+    return node_list_type {
+        { first_id,     osmium::Location(x,       y      ) },
+        { first_id + 1, osmium::Location(x + 1.0, y      ) },
+        { first_id + 2, osmium::Location(x + 1.0, y + 1.0) },
+        { first_id + 3, osmium::Location(x,       y + 1.0) },
+        { first_id,     osmium::Location(x,       y      ) }
+    };
+}
+
+struct AreaIds : public osmium::handler::Handler {
+
+    std::vector<osmium::object_id_type> ids;
+
+    void area(const osmium::Area& area) {
+        ids.push_back(area.id());
+    }
+
+}; // struct AreaIds
+
+typedef osmium::area::MultipolygonCollector<osmium::area::Assembler> collector_type;
+
+static std::vector<osmium::object_id_type> assemble_pass2(collector_type& collector, const osmium::memory::Buffer& buffer, size_t memory_limit = 0) {
+
+    AreaIds handler;
+    osmium::apply(buffer.cbegin(), buffer.cend(), collector.handler([&handler](const osmium::memory::Buffer& area_buffer) {
+        osmium::apply(area_buffer, handler);
+    }));
+    osmium::memory::Buffer rest = collector.read();
+    osmium::apply(rest, handler);
+
+    REQUIRE(collector.get_incomplete_relations().empty());
+    if (memory_limit > 0) {
+        REQUIRE(collector.spilled_size() > 0);
+        // everything spilled was read back, so the spill file is empty again
+        REQUIRE(collector.spill_file_size() == 0);
+    }
+    return handler.ids;
+}
+
+static std::vector<osmium::object_id_type> assemble(const osmium::memory::Buffer& buffer, bool parallel, size_t memory_limit = 0) {
+    osmium::area::Assembler::config_type config;
+    collector_type collector(config, parallel);
+    collector.members_memory_limit(memory_limit);
+    collector.read_relations(buffer.cbegin(), buffer.cend());
+    return assemble_pass2(collector, buffer, memory_limit);
+}
+
+static void fill_buffer(osmium::memory::Buffer& buffer) {
+
+    for (osmium::object_id_type id = 1; id <= 40; ++id) {
+        buffer_add_way(buffer, "foo", {{"building", "yes"}}, square(id * 10, static_cast<double>(id) * 2, 0.0)).id(id);
+    }
+    for (osmium::object_id_type id = 1; id <= 10; ++id) {
+        buffer_add_relation(buffer, "foo", {{"type", "multipolygon"}, {"landuse", "forest"}}, {
+            std::make_tuple('w', id * 4, "outer"),
+            std::make_tuple('w', id * 4 - 1, "outer")
+        }).id(id);
+    }
+}
+
+TEST_CASE("MultipolygonCollector") {
+
+    osmium::memory::Buffer buffer(10240);
+    fill_buffer(buffer);
+
+    const std::vector<osmium::object_id_type> serial = assemble(buffer, false);
+    const std::vector<osmium::object_id_type> parallel = assemble(buffer, true);
+    const std::vector<osmium::object_id_type> spilled = assemble(buffer, false, 1);
+
+    // 20 ways not in any relation and 10 relations
+    REQUIRE(serial.size() == 30);
+    REQUIRE(serial == parallel);
+    REQUIRE(serial == spilled);
+    REQUIRE(std::count(serial.begin(), serial.end(), 3) == 1); // relation 1
+    REQUIRE(std::count(serial.begin(), serial.end(), 2) == 1); // way 1
+    REQUIRE(std::count(serial.begin(), serial.end(), 8) == 0); // way 4 is in relation 1
+}
+
+TEST_CASE("MultipolygonCollector with cached first pass") {
+
+    osmium::memory::Buffer buffer(10240);
+    fill_buffer(buffer);
+
+    // stands in for the input file, only its identity is used
+    char input[] = "/tmp/osmium_unit_test_XXXXXX";
+    const int fd = mkstemp(input);
+    REQUIRE(fd > 0);
+    REQUIRE(1 == write(fd, "x", 1));
+    const std::string cache = std::string(input) + ".cache";
+
+    osmium::area::Assembler::config_type config;
+
+    collector_type collector1(config);
+    REQUIRE_FALSE(collector1.load_relations(cache, input));
+    collector1.read_relations(buffer.cbegin(), buffer.cend());
+    REQUIRE(collector1.save_relations(cache, input));
+    REQUIRE_FALSE(collector1.save_relations(cache, "-"));
+
+    // the temporary file was renamed into place
+    REQUIRE(0 != access((cache + ".tmp." + std::to_string(getpid())).c_str(), F_OK));
+
+    collector_type collector2(config);
+    REQUIRE(collector2.load_relations(cache, input));
+    REQUIRE(assemble_pass2(collector2, buffer) == assemble_pass2(collector1, buffer));
+
+    // cache is stale if only the nanoseconds of the modification time differ
+    struct stat s;
+    REQUIRE(0 == fstat(fd, &s));
+    struct timespec times[2] = { s.st_atim, s.st_mtim };
+    times[1].tv_nsec = (times[1].tv_nsec + 1) % 1000000000;
+    REQUIRE(0 == futimens(fd, times));
+    collector_type collector3(config);
+    REQUIRE_FALSE(collector3.load_relations(cache, input));
+
+    // cache written by a different format version is ignored
+    REQUIRE(collector1.save_relations(cache, input));
+    const int cache_fd = open(cache.c_str(), O_WRONLY);
+    REQUIRE(cache_fd > 0);
+    const uint64_t version = 0;
+    REQUIRE(sizeof(version) == pwrite(cache_fd, &version, sizeof(version), 8));
+    REQUIRE(0 == close(cache_fd));
+    collector_type collector4(config);
+    REQUIRE_FALSE(collector4.load_relations(cache, input));
+
+    // cache is stale after the input changed
+    REQUIRE(collector1.save_relations(cache, input));
+    REQUIRE(1 == write(fd, "x", 1));
+    collector_type collector5(config);
+    REQUIRE_FALSE(collector5.load_relations(cache, input));
+
+    REQUIRE(0 == close(fd));
+    REQUIRE(0 == unlink(input));
+    REQUIRE(0 == unlink(cache.c_str()));
+}
+
+TEST_CASE("MultipolygonCollector with ways in several relations") {
+
+    osmium::memory::Buffer buffer(10240);
+    for (osmium::object_id_type id = 1; id <= 4; ++id) {
+        buffer_add_way(buffer, "foo", {}, square(id * 10, static_cast<double>(id) * 2, 0.0)).id(id);
+    }
+    // every way is used by at least two relations
+    for (osmium::object_id_type id = 1; id <= 6; ++id) {
+        buffer_add_relation(buffer, "foo", {{"type", "multipolygon"}, {"landuse", "forest"}}, {
+            std::make_tuple('w', (id - 1) % 4 + 1, "outer"),
+            std::make_tuple('w', id % 4 + 1, "outer")
+        }).id(id);
+    }
+
+    const std::vector<osmium::object_id_type> serial = assemble(buffer, false);
+    REQUIRE(serial.size() == 6);
+    REQUIRE(serial == assemble(buffer, true));
+    REQUIRE(serial == assemble(buffer, false, 1));
+}
+
+typedef osmium::area::MultipolygonCollector<osmium::area::Assembler> mp_collector_type;
+
+struct InspectableCollector : public mp_collector_type {
+
+    InspectableCollector(const osmium::area::Assembler::config_type& config, bool parallel) :
+        mp_collector_type(config, parallel) {
+    }
+
+    using mp_collector_type::member_meta;
+
+    size_t num_removed_ways() {
+        const auto& mmv = member_meta(osmium::item_type::way);
+        return static_cast<size_t>(std::count_if(mmv.begin(), mmv.end(), [](const osmium::relations::MemberMeta& mm) {
+            return mm.removed();
+        }));
+    }
+
+    bool has_live_member(osmium::object_id_type id) {
+        const auto& buffer = members_buffer();
+        return std::any_of(buffer.cbegin<osmium::Way>(), buffer.cend<osmium::Way>(), [id](const osmium::Way& way) {
+            return way.id() == id && !way.removed();
+        });
+    }
+
+}; // struct InspectableCollector
+
+TEST_CASE("MultipolygonCollector marks and compacts member meta of completed relations") {
+
+    osmium::memory::Buffer relations(10240);
+    // relation n uses ways (n - 1) % 4 + 1 and n % 4 + 1
+    for (osmium::object_id_type id = 1; id <= 6; ++id) {
+        buffer_add_relation(relations, "foo", {{"type", "multipolygon"}, {"landuse", "forest"}}, {
+            std::make_tuple('w', (id - 1) % 4 + 1, "outer"),
+            std::make_tuple('w', id % 4 + 1, "outer")
+        }).id(id);
+    }
+
+    osmium::memory::Buffer ways12(10240);
+    osmium::memory::Buffer way3(10240);
+    osmium::memory::Buffer way4(10240);
+    for (osmium::object_id_type id = 1; id <= 4; ++id) {
+        osmium::memory::Buffer& buffer = id <= 2 ? ways12 : (id == 3 ? way3 : way4);
+        buffer_add_way(buffer, "foo", {}, square(id * 10, static_cast<double>(id) * 2, 0.0)).id(id);
+    }
+
+    osmium::area::Assembler::config_type config;
+    InspectableCollector collector(config, false);
+    collector.read_relations(relations.cbegin(), relations.cend());
+    REQUIRE(collector.member_meta(osmium::item_type::way).size() == 12);
+
+    auto& handler = collector.handler([](const osmium::memory::Buffer&) {});
+
+    // completes relations 1 and 5
+    osmium::apply(ways12, handler);
+    REQUIRE(collector.num_removed_ways() == 4);
+    REQUIRE(collector.member_meta(osmium::item_type::way).size() == 12);
+    REQUIRE(collector.has_live_member(1)); // still needed by relation 4
+    REQUIRE(collector.has_live_member(2)); // still needed by relations 2 and 6
+
+    // completes relations 2 and 6, 8 of 12 entries are removed now
+    osmium::apply(way3, handler);
+    REQUIRE(collector.num_removed_ways() == 0);
+    REQUIRE(collector.member_meta(osmium::item_type::way).size() == 4);
+    REQUIRE(collector.has_live_member(1));
+    REQUIRE_FALSE(collector.has_live_member(2)); // all its relations are done
+    REQUIRE(collector.has_live_member(3));
+
+    // completes relations 3 and 4
+    osmium::apply(way4, handler);
+    REQUIRE(collector.member_meta(osmium::item_type::way).empty());
+    REQUIRE(collector.get_incomplete_relations().empty());
+}
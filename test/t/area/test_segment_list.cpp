@@ -0,0 +1,88 @@
+#include "catch.hpp"
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "../basic/helper.hpp"
+
+using osmium::area::detail::NodeRefSegment;
+
+typedef std::vector<std::tuple<osmium::object_id_type, osmium::object_id_type, osmium::Location>> intersection_list_type;
+
+struct IntersectionReporter : public osmium::area::ProblemReporter {
+
+    intersection_list_type intersections;
+
+    void report_intersection(osmium::object_id_type way1_id, osmium::Location, osmium::Location,
+                             osmium::object_id_type way2_id, osmium::Location, osmium::Location, osmium::Location intersection) override {
+        intersections.emplace_back(way1_id, way2_id, intersection);
+    }
+
+}; // struct IntersectionReporter
+
+static intersection_list_type check_all_pairs(const osmium::area::detail::SegmentList& segment_list) {
+    intersection_list_type intersections;
+    for (auto it1 = segment_list.begin(); it1 != segment_list.end(); ++it1) {
+        for (auto it2 = it1 + 1; it2 != segment_list.end(); ++it2) {
+            const osmium::Location intersection = osmium::area::detail::calculate_intersection(*it1, *it2);
+            if (intersection) {
+                intersections.emplace_back(it1->way()->id(), it2->way()->id(), intersection);
+            }
+        }
+    }
+    return intersections;
+}
+
+static void check_segments(size_t num_ways, int32_t max_length) {
+    std::mt19937 gen(num_ways);
+    std::uniform_int_distribution<int32_t> coord(0, 1000000);
+    std::uniform_int_distribution<int32_t> length(-max_length, max_length);
+    std::uniform_int_distribution<int32_t> height(-1000, 1000);
+
+    osmium::memory::Buffer buffer(1024 * 1024);
+    osmium::object_id_type node_id = 1;
+    for (osmium::object_id_type id = 1; id <= static_cast<osmium::object_id_type>(num_ways); ++id) {
+        const int32_t x = coord(gen);
+        const int32_t y = coord(gen);
+        buffer_add_way(buffer, "foo", {}, {
+            { node_id,     osmium::Location(x, y) },
+            { node_id + 1, osmium::Location(x + length(gen), y + height(gen)) }
+        }).id(id);
+        node_id += 2;
+    }
+
+    osmium::area::detail::SegmentList segment_list(false);
+    for (auto it = buffer.begin<osmium::Way>(); it != buffer.end<osmium::Way>(); ++it) {
+        segment_list.extract_segments_from_way(*it, "outer");
+    }
+    segment_list.sort();
+    segment_list.erase_duplicate_segments();
+
+    IntersectionReporter reporter;
+    const bool found = segment_list.find_intersections(&reporter);
+
+    const intersection_list_type expected = check_all_pairs(segment_list);
+    REQUIRE(found == !expected.empty());
+    REQUIRE(reporter.intersections == expected);
+}
+
+TEST_CASE("Segment list intersections") {
+
+    SECTION("few segments") {
+        check_segments(40, 200000);
+    }
+
+    SECTION("many short segments") {
+        check_segments(2000, 20000);
+    }
+
+    SECTION("many long east-west segments") {
+        check_segments(2000, 500000);
+    }
+
+}
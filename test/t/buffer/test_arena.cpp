@@ -0,0 +1,67 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <list>
+#include <type_traits>
+#include <vector>
+
+#include <osmium/memory/arena.hpp>
+
+TEST_CASE("Arena") {
+
+    osmium::memory::Arena arena(1024);
+
+    SECTION("allocations are aligned and don't overlap") {
+        char* c = static_cast<char*>(arena.allocate(1, 1));
+        uint64_t* p = static_cast<uint64_t*>(arena.allocate(sizeof(uint64_t), alignof(uint64_t)));
+        REQUIRE((reinterpret_cast<uintptr_t>(p) % alignof(uint64_t)) == 0);
+        REQUIRE(reinterpret_cast<char*>(p) > c);
+        REQUIRE(arena.capacity() == 1024);
+    }
+
+    SECTION("arenas can't be moved, allocators point to them") {
+        REQUIRE_FALSE(std::is_move_constructible<osmium::memory::Arena>::value);
+        REQUIRE_FALSE(std::is_move_assignable<osmium::memory::Arena>::value);
+    }
+
+    SECTION("large allocations get their own block") {
+        arena.allocate(100);
+        arena.allocate(5000);
+        REQUIRE(arena.capacity() >= 1024 + 5000);
+    }
+
+    SECTION("memory is reused after reset") {
+        void* first = arena.allocate(500);
+        arena.allocate(500);
+        arena.allocate(500);
+        const size_t capacity = arena.capacity();
+        REQUIRE(capacity == 2048);
+
+        arena.reset();
+        REQUIRE(arena.allocate(500) == first);
+        arena.allocate(500);
+        arena.allocate(500);
+        REQUIRE(arena.capacity() == capacity);
+
+        arena.release();
+        REQUIRE(arena.capacity() == 0);
+    }
+
+    SECTION("containers") {
+        for (int run = 0; run < 3; ++run) {
+            {
+                std::vector<int, osmium::memory::ArenaAllocator<int>> v(arena);
+                std::list<int, osmium::memory::ArenaAllocator<int>> l(arena);
+                for (int i = 0; i < 100; ++i) {
+                    v.push_back(i);
+                    l.push_back(i);
+                }
+                REQUIRE(v.size() == 100);
+                REQUIRE(l.back() == 99);
+            }
+            arena.reset();
+        }
+        REQUIRE(arena.capacity() < 10 * 1024);
+    }
+
+}
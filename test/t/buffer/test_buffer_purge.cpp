@@ -0,0 +1,66 @@
+#include "catch.hpp"
+
+#include <utility>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+
+#include "../basic/helper.hpp"
+
+struct CallbackClass {
+
+    std::vector<std::pair<size_t, size_t>> moves;
+
+    void moving_in_buffer(size_t old_offset, size_t new_offset) {
+        moves.emplace_back(old_offset, new_offset);
+    }
+
+}; // struct CallbackClass
+
+TEST_CASE("Purge data from buffer") {
+
+    osmium::memory::Buffer buffer(10000);
+
+    SECTION("purge empty buffer") {
+        CallbackClass callback;
+        buffer.purge_removed(&callback);
+        REQUIRE(callback.moves.empty());
+        REQUIRE(buffer.committed() == 0);
+    }
+
+    SECTION("purge removed items of different sizes") {
+        std::vector<size_t> offsets;
+        for (int i = 0; i < 10; ++i) {
+            offsets.push_back(buffer.committed());
+            // every other node has a long user name and more tags
+            if (i % 2) {
+                buffer_add_node(buffer, "a_long_user_name_to_make_the_node_larger", {{"a", "b"}, {"c", "d"}}, osmium::Location(1.0, 1.0)).id(i);
+            } else {
+                buffer_add_node(buffer, "u", {}, osmium::Location(1.0, 1.0)).id(i);
+            }
+        }
+        const size_t node1_size = buffer.get<osmium::Node>(offsets[1]).padded_size();
+
+        for (int i = 1; i < 10; i += 2) {
+            buffer.get<osmium::Node>(offsets[i]).removed(true);
+        }
+
+        CallbackClass callback;
+        buffer.purge_removed(&callback);
+
+        REQUIRE(callback.moves.size() == 4);
+        REQUIRE(callback.moves[0].first == offsets[2]);
+        REQUIRE(callback.moves[0].second == offsets[1]);
+        REQUIRE(buffer.committed() == offsets[9] - 4 * node1_size);
+
+        int n = 0;
+        for (auto it = buffer.begin<osmium::Node>(); it != buffer.end<osmium::Node>(); ++it) {
+            REQUIRE(it->id() == n);
+            REQUIRE(!it->removed());
+            n += 2;
+        }
+        REQUIRE(n == 10);
+    }
+
+}
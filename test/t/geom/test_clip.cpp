@@ -0,0 +1,216 @@
+#include "catch.hpp"
+
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <osmium/builder/builder_helper.hpp>
+#include <osmium/geom/clip.hpp>
+#include <osmium/geom/wkt.hpp>
+
+#include "../basic/helper.hpp"
+
+using osmium::geom::Coordinates;
+
+static std::vector<Coordinates> coordinates(std::initializer_list<std::pair<double, double>> list) {
+    std::vector<Coordinates> result;
+    for (const auto& c : list) {
+        result.emplace_back(c.first, c.second);
+    }
+    return result;
+}
+
+TEST_CASE("ClipBox") {
+
+    osmium::geom::ClipBox box{Coordinates{10, 0}, Coordinates{0, 10}};
+
+SECTION("corners") {
+    REQUIRE(box.min() == Coordinates(0, 0));
+    REQUIRE(box.max() == Coordinates(10, 10));
+}
+
+SECTION("segment") {
+    Coordinates a{-5, 5};
+    Coordinates b{5, 15};
+    REQUIRE(box.clip_segment(a, b));
+    REQUIRE(a == Coordinates(0, 10));
+    REQUIRE(b == Coordinates(0, 10));
+
+    a = Coordinates{-5, 5};
+    b = Coordinates{15, 5};
+    REQUIRE(box.clip_segment(a, b));
+    REQUIRE(a == Coordinates(0, 5));
+    REQUIRE(b == Coordinates(10, 5));
+
+    a = Coordinates{-5, 5};
+    b = Coordinates{5, 25};
+    REQUIRE_FALSE(box.clip_segment(a, b));
+
+    a = Coordinates{11, 5};
+    b = Coordinates{15, 5};
+    REQUIRE_FALSE(box.clip_segment(a, b));
+}
+
+SECTION("linestring_in_pieces") {
+    const std::vector<Coordinates> line = coordinates({{-5, 2}, {5, 2}, {5, 15}, {8, 15}, {8, 5}, {15, 5}});
+    std::vector<Coordinates> out;
+    std::vector<size_t> parts;
+    REQUIRE(box.clip_linestring(line.data(), line.size(), out, parts) == 2);
+    REQUIRE(parts == std::vector<size_t>({3, 3}));
+    REQUIRE(out == coordinates({{0, 2}, {5, 2}, {5, 10}, {8, 10}, {8, 5}, {10, 5}}));
+}
+
+SECTION("linestring_inside_and_outside") {
+    const std::vector<Coordinates> inside = coordinates({{1, 1}, {2, 2}, {3, 1}});
+    const std::vector<Coordinates> outside = coordinates({{-1, 1}, {-2, 20}, {-3, 1}});
+    std::vector<Coordinates> out;
+    std::vector<size_t> parts;
+    REQUIRE(box.clip_linestring(inside.data(), inside.size(), out, parts) == 1);
+    REQUIRE(box.clip_linestring(outside.data(), outside.size(), out, parts) == 0);
+    REQUIRE(out == inside);
+    REQUIRE(parts == std::vector<size_t>({3}));
+}
+
+SECTION("ring") {
+    const std::vector<Coordinates> ring = coordinates({{5, 5}, {15, 5}, {15, 15}, {5, 15}, {5, 5}});
+    std::vector<Coordinates> out;
+    REQUIRE(box.clip_ring(ring.data(), ring.size(), out) == 5);
+    REQUIRE(out == coordinates({{5, 5}, {10, 5}, {10, 10}, {5, 10}, {5, 5}}));
+}
+
+SECTION("ring_around_box") {
+    const std::vector<Coordinates> ring = coordinates({{-1, -1}, {11, -1}, {11, 11}, {-1, 11}, {-1, -1}});
+    std::vector<Coordinates> out;
+    REQUIRE(box.clip_ring(ring.data(), ring.size(), out) == 5);
+    REQUIRE(out.front() == out.back());
+}
+
+SECTION("ring_outside_box_with_overlapping_bounding_box") {
+    const std::vector<Coordinates> ring = coordinates({{-1, -1}, {20, -1}, {20, 20}, {19, 20}, {19, 0}, {-1, 0}, {-1, -1}});
+    std::vector<Coordinates> out;
+    REQUIRE(box.clip_ring(ring.data(), ring.size(), out) == 0);
+    REQUIRE(out.empty());
+}
+
+}
+
+TEST_CASE("GeometryFactory with clip box") {
+
+    osmium::geom::WKTFactory<> factory;
+    factory.set_clip_box(osmium::Box{0.0, 0.0, 10.0, 10.0});
+
+    osmium::memory::Buffer buffer(10000);
+
+SECTION("linestring") {
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {-5.0, 2.0}},
+        {2, {5.0, 2.0}},
+        {3, {5.0, 8.0}}
+    });
+
+    REQUIRE(std::string{"LINESTRING(0 2,5 2,5 8)"} == factory.create_linestring(wnl));
+
+    factory.clear_clip_box();
+    REQUIRE_FALSE(factory.has_clip_box());
+    REQUIRE(std::string{"LINESTRING(-5 2,5 2,5 8)"} == factory.create_linestring(wnl));
+}
+
+SECTION("linestring_in_pieces") {
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {2.0, 5.0}},
+        {2, {2.0, 15.0}},
+        {3, {8.0, 15.0}},
+        {4, {8.0, 5.0}}
+    });
+
+    REQUIRE_THROWS_AS(factory.create_linestring(wnl), osmium::geometry_error);
+
+    std::vector<std::string> pieces;
+    REQUIRE(factory.create_linestrings(wnl, [&pieces](const std::string& wkt) {
+        pieces.push_back(wkt);
+    }) == 2);
+    REQUIRE(pieces == std::vector<std::string>({"LINESTRING(2 5,2 10)", "LINESTRING(8 10,8 5)"}));
+}
+
+SECTION("linestring_outside") {
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {12.0, 5.0}},
+        {2, {13.0, 5.0}}
+    });
+
+    REQUIRE_THROWS_AS(factory.create_linestring(wnl), osmium::geometry_error);
+    REQUIRE(factory.create_linestrings(wnl, [](const std::string&) {}) == 0);
+}
+
+SECTION("linestring_append") {
+    std::string out;
+    osmium::geom::WKTAppendFactory<> append_factory(out);
+    append_factory.set_clip_box(osmium::Box{0.0, 0.0, 10.0, 10.0});
+
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {2.0, 5.0}},
+        {2, {2.0, 15.0}},
+        {3, {8.0, 15.0}},
+        {4, {8.0, 5.0}}
+    });
+
+    REQUIRE(append_factory.create_linestrings(wnl, [&out]() {
+        out += '\n';
+    }) == 2);
+    REQUIRE(std::string{"LINESTRING(2 5,2 10)\nLINESTRING(8 10,8 5)\n"} == out);
+}
+
+SECTION("area") {
+    osmium::Area& area = buffer_add_area(buffer,
+        "foo",
+        {},
+        {
+            { true, {
+                {1, {5.0, 5.0}},
+                {2, {15.0, 5.0}},
+                {3, {15.0, 15.0}},
+                {4, {5.0, 15.0}},
+                {1, {5.0, 5.0}}
+            }},
+            { false, {
+                {5, {6.0, 6.0}},
+                {6, {6.0, 12.0}},
+                {7, {12.0, 12.0}},
+                {8, {12.0, 6.0}},
+                {5, {6.0, 6.0}}
+            }},
+            { true, {
+                {11, {20.0, 20.0}},
+                {12, {21.0, 20.0}},
+                {13, {21.0, 21.0}},
+                {11, {20.0, 20.0}}
+            }},
+            { false, {
+                {15, {20.1, 20.1}},
+                {16, {20.2, 20.1}},
+                {17, {20.2, 20.2}},
+                {15, {20.1, 20.1}}
+            }}
+        });
+
+    REQUIRE(std::string{"MULTIPOLYGON(((5 5,10 5,10 10,5 10,5 5),(6 6,6 10,10 10,10 6,6 6)))"} == factory.create_multipolygon(area));
+}
+
+SECTION("area_outside") {
+    osmium::Area& area = buffer_add_area(buffer,
+        "foo",
+        {},
+        {
+            { true, {
+                {1, {20.0, 20.0}},
+                {2, {21.0, 20.0}},
+                {3, {21.0, 21.0}},
+                {1, {20.0, 20.0}}
+            }}
+        });
+
+    REQUIRE_THROWS_AS(factory.create_multipolygon(area), osmium::geometry_error);
+}
+
+}
@@ -0,0 +1,47 @@
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <string>
+
+#include <osmium/geom/coordinates.hpp>
+
+static std::string to_string(double value) {
+    std::string s;
+    osmium::geom::detail::double2string(s, value);
+    return s;
+}
+
+TEST_CASE("Coordinates") {
+
+SECTION("fixed_point") {
+    REQUIRE(std::string{"0"} == to_string(0.0));
+    REQUIRE(std::string{"3"} == to_string(3.0));
+    REQUIRE(std::string{"-0.5"} == to_string(-0.5));
+    REQUIRE(std::string{"3.1234567"} == to_string(3.1234567));
+    REQUIRE(std::string{"-179.9999999"} == to_string(-179.9999999));
+    REQUIRE(std::string{"0.0000001"} == to_string(0.0000001));
+    REQUIRE(std::string{"-0.0000001"} == to_string(-0.0000001));
+    REQUIRE(std::string{"100"} == to_string(100.0));
+}
+
+SECTION("locations") {
+    for (int32_t c : { 0, 1, -1, 10, 1234567, -1799999999, 1800000000, 899999999 }) {
+        const double value = osmium::Location::fix_to_double(c);
+        REQUIRE(std::strtod(to_string(value).c_str(), nullptr) == value);
+    }
+}
+
+SECTION("shortest_round_trip") {
+    REQUIRE(std::string{"0.30000000000000004"} == to_string(0.1 + 0.2));
+    REQUIRE(std::string{"356222.37053847546"} == to_string(356222.37053847546));
+    REQUIRE(std::string{"0.12345678"} == to_string(0.12345678));
+    REQUIRE(std::string{"1e+20"} == to_string(1e20));
+}
+
+SECTION("append_to_string") {
+    std::string s {"POINT"};
+    osmium::geom::Coordinates(osmium::Location(3.2, 4.2)).append_to_string(s, '(', ' ', ')');
+    REQUIRE(std::string{"POINT(3.2 4.2)"} == s);
+}
+
+}
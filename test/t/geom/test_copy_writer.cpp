@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include <cstdio>
+#include <string>
+
+#include <osmium/builder/builder_helper.hpp>
+#include <osmium/geom/copy_writer.hpp>
+#include <osmium/geom/wkb.hpp>
+
+static std::string read_file(std::FILE* file) {
+    std::string content;
+    std::rewind(file);
+    char buffer[1024];
+    size_t length;
+    while ((length = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.append(buffer, length);
+    }
+    return content;
+}
+
+TEST_CASE("CopyWriter") {
+
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file);
+
+SECTION("columns") {
+    {
+        osmium::geom::CopyWriter writer(fileno(file));
+        writer.add(17).add("foo").add_null();
+        writer.end_row();
+        writer.add(-3).add("a\tb\nc\\d\re").add(std::string{});
+        writer.end_row();
+    }
+    REQUIRE(read_file(file) == "17\tfoo\t\\N\n-3\ta\\tb\\nc\\\\d\\re\t\n");
+}
+
+SECTION("flush") {
+    osmium::geom::CopyWriter writer(fileno(file), 8);
+    writer.add("abcdefgh");
+    writer.end_row();
+    writer.add("x");
+    REQUIRE(read_file(file) == "abcdefgh\n");
+    writer.end_row();
+    writer.flush();
+    REQUIRE(read_file(file) == "abcdefgh\nx\n");
+}
+
+SECTION("geometry") {
+    {
+        osmium::geom::CopyWriter writer(fileno(file));
+        osmium::geom::WKBAppendFactory<> factory(writer.buffer(), osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex);
+
+        writer.add(1);
+        writer.add_column();
+        factory.create_point(osmium::Location(3.2, 4.2));
+        writer.end_row();
+
+        osmium::memory::Buffer buffer(10000);
+        auto& wnl = osmium::builder::build_way_node_list(buffer, {
+            {1, {3.2, 4.2}}
+        });
+
+        writer.add(2);
+        writer.add_column();
+        REQUIRE_THROWS_AS(factory.create_linestring(wnl), osmium::geometry_error);
+        writer.abort_row();
+    }
+    REQUIRE(read_file(file) == "1\t0101000020E61000009A99999999990940CDCCCCCCCCCC1040\n");
+}
+
+    std::fclose(file);
+}
@@ -1,5 +1,7 @@
 #include "catch.hpp"
 
+#include <cstdio>
+
 #include <osmium/geom/geos.hpp>
 #include <osmium/geom/mercator_projection.hpp>
 #include <osmium/geom/projection.hpp>
@@ -14,14 +16,18 @@ SECTION("point_mercator") {
     osmium::geom::WKTFactory<osmium::geom::MercatorProjection> factory;
 
     std::string wkt {factory.create_point(osmium::Location(3.2, 4.2))};
-    REQUIRE(std::string{"POINT(356222.370538 467961.143605)"} == wkt);
+    REQUIRE(std::string{"POINT(356222.37053847546 467961.14360521396)"} == wkt);
 }
 
 SECTION("point_epsg_3857") {
     osmium::geom::WKTFactory<osmium::geom::Projection> factory(osmium::geom::Projection(3857));
 
     std::string wkt {factory.create_point(osmium::Location(3.2, 4.2))};
-    REQUIRE(std::string{"POINT(356222.370538 467961.143605)"} == wkt);
+    double x = 0.0;
+    double y = 0.0;
+    REQUIRE(std::sscanf(wkt.c_str(), "POINT(%lf %lf)", &x, &y) == 2);
+    REQUIRE(x == Approx(356222.370538));
+    REQUIRE(y == Approx(467961.143605));
 }
 
 SECTION("wkb_with_parameter") {
@@ -195,4 +195,55 @@ SECTION("area_2outer_2inner") {
     REQUIRE(5 == l1e->getNumPoints());
 }
 
+SECTION("shared_geos_factory") {
+    geos::geom::PrecisionModel precision_model;
+    geos::geom::GeometryFactory geos_factory(&precision_model, 4326);
+    osmium::geom::GEOSFactory<> factory(geos_factory);
+
+    osmium::memory::Buffer buffer(10000);
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {3.2, 4.2}},
+        {2, {3.6, 4.9}}
+    });
+
+    std::unique_ptr<geos::geom::LineString> linestring {factory.create_linestring(wnl)};
+    REQUIRE(2 == linestring->getNumPoints());
+    REQUIRE(4326 == linestring->getSRID());
+    REQUIRE(&geos_factory == linestring->getFactory());
+}
+
+SECTION("prepared_area") {
+    osmium::geom::GEOSFactory<> factory;
+
+    osmium::memory::Buffer buffer(10000);
+    osmium::Area& area = buffer_add_area(buffer,
+        "foo",
+        {},
+        {
+            { true, {
+                {1, {0.1, 0.1}},
+                {2, {9.1, 0.1}},
+                {3, {9.1, 9.1}},
+                {4, {0.1, 9.1}},
+                {1, {0.1, 0.1}}
+            }},
+            { false, {
+                {5, {1.0, 1.0}},
+                {6, {8.0, 1.0}},
+                {7, {8.0, 8.0}},
+                {8, {1.0, 8.0}},
+                {5, {1.0, 1.0}}
+            }}
+        });
+
+    osmium::geom::GEOSPreparedGeometry prepared {factory.create_multipolygon(area)};
+    REQUIRE(1 == prepared.geometry().getNumGeometries());
+
+    REQUIRE(prepared.contains(*factory.create_point(osmium::Location(0.5, 0.5))));
+    REQUIRE_FALSE(prepared.contains(*factory.create_point(osmium::Location(5.0, 5.0))));
+    REQUIRE_FALSE(prepared.contains(*factory.create_point(osmium::Location(10.0, 10.0))));
+    REQUIRE(prepared.covers(*factory.create_point(osmium::Location(0.1, 0.1))));
+    REQUIRE(prepared.intersects(*factory.create_point(osmium::Location(1.0, 1.0))));
+}
+
 }
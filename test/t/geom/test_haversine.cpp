@@ -0,0 +1,82 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include <osmium/builder/builder_helper.hpp>
+#include <osmium/geom/haversine.hpp>
+
+#include "../basic/helper.hpp"
+
+TEST_CASE("Haversine") {
+
+    osmium::memory::Buffer buffer(10000);
+
+SECTION("way_length") {
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {8.6, 49.4}},
+        {2, {8.61, 49.401}},
+        {3, {8.6123456, 49.4123456}},
+        {4, {8.6123456, 49.4123456}},
+        {5, {8.5, 49.3}}
+    });
+
+    const double length = osmium::geom::haversine::distance(wnl);
+    REQUIRE(length > 0.0);
+
+    osmium::geom::haversine::WayLengthCalculator calculator;
+    REQUIRE(calculator.length(wnl) == Approx(length).epsilon(1e-12));
+
+    osmium::geom::haversine::WayLengthCalculator equirectangular(osmium::geom::haversine::method::equirectangular);
+    REQUIRE(equirectangular.length(wnl) == Approx(length).epsilon(1e-5));
+}
+
+SECTION("long_segments") {
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {-170.0, -80.0}},
+        {2, {170.0, 80.0}},
+        {3, {-179.9, 0.0}},
+        {4, {179.9, 0.1}}
+    });
+
+    osmium::geom::haversine::WayLengthCalculator calculator;
+    REQUIRE(calculator.length(wnl) == Approx(osmium::geom::haversine::distance(wnl)).epsilon(1e-12));
+}
+
+SECTION("short_way") {
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {8.6, 49.4}}
+    });
+
+    osmium::geom::haversine::WayLengthCalculator calculator;
+    REQUIRE(calculator.length(wnl) == 0.0);
+}
+
+SECTION("invalid_location") {
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {8.6, 49.4}},
+        {2, osmium::Location()}
+    });
+
+    osmium::geom::haversine::WayLengthCalculator calculator;
+    REQUIRE_THROWS_AS(calculator.length(wnl), osmium::invalid_location);
+}
+
+SECTION("buffer") {
+    buffer_add_way(buffer, "foo", {}, {{1, {8.6, 49.4}}, {2, {8.61, 49.41}}});
+    buffer_add_node(buffer, "foo", {}, osmium::Location(1.0, 2.0));
+    buffer_add_way(buffer, "foo", {}, {{3, {0.0, 0.0}}});
+    buffer_add_way(buffer, "foo", {}, {{4, {0.0, 0.0}}, {5, {0.0, 1.0}}, {6, {1.0, 1.0}}});
+
+    std::vector<double> lengths;
+    osmium::geom::haversine::WayLengthCalculator calculator;
+    calculator.lengths(buffer, [&lengths](const osmium::Way& way, double length) {
+        REQUIRE(osmium::geom::haversine::distance(way.nodes()) == Approx(length).epsilon(1e-12));
+        lengths.push_back(length);
+    });
+
+    REQUIRE(lengths.size() == 3);
+    REQUIRE(lengths[1] == 0.0);
+    REQUIRE(lengths[2] == Approx(2 * 111194.9).epsilon(1e-2));
+}
+
+}
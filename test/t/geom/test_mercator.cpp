@@ -1,5 +1,8 @@
 #include "catch.hpp"
 
+#include <cmath>
+#include <vector>
+
 #include <osmium/geom/mercator_projection.hpp>
 
 TEST_CASE("Mercator") {
@@ -34,4 +37,35 @@ SECTION("mercator_bounds") {
     REQUIRE((osmium::geom::MERCATOR_MAX_LAT - osmium::geom::detail::y_to_lat(osmium::geom::detail::lon_to_x(180.0))) < 0.0000001);
 }
 
+SECTION("lat_to_y_compared_to_log_tan") {
+    for (int i = -850511; i <= 850511; i += 7) {
+        const double lat = i / 10000.0;
+        const double y = osmium::geom::detail::EARTH_RADIUS_FOR_EPSG3857 * std::log(std::tan(osmium::geom::PI/4 + osmium::geom::deg_to_rad(lat)/2));
+        REQUIRE(std::abs(osmium::geom::detail::lat_to_y(lat) - y) < 0.0000001);
+    }
+}
+
+SECTION("batch_projection") {
+    std::vector<osmium::Location> locations;
+    for (int i = -89; i <= 89; ++i) {
+        locations.emplace_back(i * 2.01, i + 0.123);
+    }
+    locations.emplace_back(180.0, osmium::geom::MERCATOR_MAX_LAT);
+    locations.emplace_back(-180.0, -osmium::geom::MERCATOR_MAX_LAT);
+
+    osmium::geom::MercatorProjection projection;
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    projection.project(locations.data(), coordinates.data(), locations.size());
+
+    for (size_t i = 0; i < locations.size(); ++i) {
+        const osmium::geom::Coordinates c = projection(locations[i]);
+        REQUIRE(std::abs(c.x - coordinates[i].x) < 0.0000001);
+        REQUIRE(std::abs(c.y - coordinates[i].y) < 0.0000001);
+    }
+
+    locations.emplace_back();
+    coordinates.resize(locations.size());
+    REQUIRE_THROWS_AS(projection.project(locations.data(), coordinates.data(), locations.size()), osmium::invalid_location);
+}
+
 }
@@ -1,5 +1,7 @@
 #include "catch.hpp"
 
+#include <vector>
+
 #include <osmium/geom/factory.hpp>
 #include <osmium/geom/mercator_projection.hpp>
 #include <osmium/geom/projection.hpp>
@@ -128,4 +130,60 @@ SECTION("compare_mercators") {
     }
 }
 
+SECTION("batch_projection") {
+    std::vector<osmium::Location> locations {
+        osmium::Location(4.2, 27.3),
+        osmium::Location(160.789, -42.42),
+        osmium::Location(-0.001, 0.001),
+        osmium::Location(-85.2, -85.2)
+    };
+
+    for (int epsg : {4326, 3857, 31467}) {
+        osmium::geom::Projection projection(epsg);
+        std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+        projection.project(locations.data(), coordinates.data(), locations.size());
+        for (size_t i = 0; i < locations.size(); ++i) {
+            REQUIRE(std::abs(projection(locations[i]).x - coordinates[i].x) < 0.0001);
+            REQUIRE(std::abs(projection(locations[i]).y - coordinates[i].y) < 0.0001);
+        }
+    }
+}
+
+SECTION("batch_projection_failure") {
+    // Mercator can't project the poles. Proj reports this as an error
+    // for a single point, but sets the point to HUGE_VAL if there are
+    // several.
+    std::vector<osmium::Location> locations {
+        osmium::Location(4.2, 27.3),
+        osmium::Location(0.0, 90.0),
+        osmium::Location(-0.001, 0.001)
+    };
+
+    osmium::geom::Projection projection(3857);
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    REQUIRE_THROWS_AS(projection(locations[1]), osmium::projection_error);
+    REQUIRE_THROWS_AS(projection.project(locations.data(), coordinates.data(), locations.size()), osmium::projection_error);
+}
+
+SECTION("projection_cache") {
+    osmium::geom::ProjectionCache cache(2);
+    REQUIRE(cache.size() == 0);
+
+    std::shared_ptr<osmium::geom::Projection> p3857 = cache.get(3857);
+    REQUIRE(p3857->epsg() == 3857);
+    REQUIRE(cache.get(3857) == p3857);
+
+    cache.get(4326);
+    REQUIRE(cache.get(3857) == p3857);
+    REQUIRE(cache.size() == 2);
+
+    // 4326 is the least recently used and gets removed
+    cache.get(31467);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.get(3857) == p3857);
+
+    REQUIRE_THROWS_AS(cache.get(9999999), osmium::projection_error);
+    REQUIRE(cache.size() == 2);
+}
+
 }
@@ -121,5 +121,51 @@ SECTION("linestring_with_undefined_location") {
     REQUIRE_THROWS_AS(factory.create_linestring(wnl), osmium::invalid_location);
 }
 
+SECTION("append_hex_to_string") {
+    std::string out;
+    osmium::geom::WKBAppendFactory<> factory(out, osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex);
+    osmium::geom::WKBFactory<> string_factory(osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex);
+
+    osmium::memory::Buffer buffer(10000);
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {3.2, 4.2}},
+        {3, {3.5, 4.7}},
+        {2, {3.6, 4.9}}
+    });
+
+    factory.create_point(osmium::Location(3.2, 4.2));
+    REQUIRE(std::string{"0101000020E61000009A99999999990940CDCCCCCCCCCC1040"} == out);
+
+    factory.create_linestring(wnl);
+    REQUIRE(out == (string_factory.create_point(osmium::Location(3.2, 4.2)) + string_factory.create_linestring(wnl)));
 }
 
+SECTION("append_binary_to_string") {
+    std::string out;
+    osmium::geom::WKBAppendFactory<> factory(out);
+    osmium::geom::WKBFactory<> string_factory;
+
+    osmium::memory::Buffer buffer(10000);
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {3.2, 4.2}},
+        {3, {3.5, 4.7}},
+        {2, {3.6, 4.9}}
+    });
+
+    factory.create_linestring(wnl);
+    factory.create_linestring(wnl, osmium::geom::use_nodes::unique, osmium::geom::direction::backward);
+    REQUIRE(out == (string_factory.create_linestring(wnl) + string_factory.create_linestring(wnl, osmium::geom::use_nodes::unique, osmium::geom::direction::backward)));
+}
+
+SECTION("hex_encoding") {
+    std::string data;
+    for (int i = 0; i < 256; ++i) {
+        data += static_cast<char>(i);
+    }
+    const std::string hex = osmium::geom::detail::convert_to_hex(data);
+    REQUIRE(hex.size() == 512);
+    REQUIRE(hex.substr(0, 8) == "00010203");
+    REQUIRE(hex.substr(504) == "FCFDFEFF");
+}
+
+}
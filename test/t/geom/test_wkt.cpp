@@ -194,5 +194,27 @@ SECTION("area_2outer_2inner") {
     }
 }
 
+SECTION("append_to_string") {
+    std::string out {"x"};
+    osmium::geom::WKTAppendFactory<> factory(out);
+
+    osmium::memory::Buffer buffer(10000);
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {3.2, 4.2}},
+        {2, {3.6, 4.9}}
+    });
+
+    factory.create_point(osmium::Location(3.2, 4.2));
+    factory.create_linestring(wnl);
+    REQUIRE(std::string{"xPOINT(3.2 4.2)LINESTRING(3.2 4.2,3.6 4.9)"} == out);
+
+    // nothing is appended if the geometry is invalid
+    auto& wnl_invalid = osmium::builder::build_way_node_list(buffer, {
+        {1, {3.2, 4.2}},
+        {2, {3.2, 4.2}}
+    });
+    REQUIRE_THROWS_AS(factory.create_linestring(wnl_invalid), osmium::geometry_error);
+    REQUIRE(std::string{"xPOINT(3.2 4.2)LINESTRING(3.2 4.2,3.6 4.9)"} == out);
 }
 
+}
@@ -0,0 +1,154 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/handler/node_locations_for_ways_stage.hpp>
+#include <osmium/index/map/stl_vector.hpp>
+
+typedef osmium::index::map::DenseMapMem<osmium::unsigned_object_id_type, osmium::Location> index_type;
+typedef osmium::handler::NodeLocationsForWays<index_type> handler_type;
+
+class BufferSource {
+
+    std::vector<osmium::memory::Buffer> m_buffers;
+    size_t m_next {0};
+
+public:
+
+    BufferSource() :
+        m_buffers() {
+    }
+
+    osmium::memory::Buffer& add_buffer() {
+        m_buffers.emplace_back(1024, osmium::memory::Buffer::auto_grow::yes);
+        return m_buffers.back();
+    }
+
+    osmium::memory::Buffer read() {
+        if (m_next == m_buffers.size()) {
+            return osmium::memory::Buffer();
+        }
+        return std::move(m_buffers[m_next++]);
+    }
+
+}; // class BufferSource
+
+void add_node(osmium::memory::Buffer& buffer, osmium::object_id_type id) {
+    {
+        osmium::builder::NodeBuilder builder(buffer);
+        builder.object().id(id);
+        builder.object().location(osmium::Location(static_cast<int32_t>(id), static_cast<int32_t>(id) + 1));
+        builder.add_user("foo");
+    }
+    buffer.commit();
+}
+
+void add_way(osmium::memory::Buffer& buffer, osmium::object_id_type id, const std::vector<osmium::object_id_type>& nodes) {
+    {
+        osmium::builder::WayBuilder builder(buffer);
+        builder.object().id(id);
+        builder.add_user("foo");
+        osmium::builder::WayNodeListBuilder wnl_builder(buffer, &builder);
+        for (const auto ref : nodes) {
+            wnl_builder.add_node_ref(ref);
+        }
+    }
+    buffer.commit();
+}
+
+TEST_CASE("NodeLocationsForWaysStage") {
+
+SECTION("ways get locations in order") {
+    BufferSource source;
+    for (int b = 0; b < 10; ++b) {
+        auto& buffer = source.add_buffer();
+        for (int n = 1; n <= 100; ++n) {
+            add_node(buffer, b * 100 + n);
+        }
+    }
+    for (int b = 0; b < 10; ++b) {
+        auto& buffer = source.add_buffer();
+        for (int w = 1; w <= 10; ++w) {
+            add_way(buffer, b * 10 + w, {b * 100 + w, b * 100 + w + 1, 1000});
+        }
+    }
+
+    index_type index;
+    handler_type handler(index);
+    osmium::handler::NodeLocationsForWaysStage<BufferSource, handler_type> stage(source, handler, 4);
+
+    int num_buffers = 0;
+    osmium::object_id_type last_way_id = 0;
+    while (osmium::memory::Buffer buffer = stage.read()) {
+        ++num_buffers;
+        for (auto it = buffer.begin<osmium::Way>(); it != buffer.end<osmium::Way>(); ++it) {
+            REQUIRE(it->id() == last_way_id + 1);
+            last_way_id = it->id();
+            for (const auto& node_ref : it->nodes()) {
+                REQUIRE(node_ref.location() == osmium::Location(static_cast<int32_t>(node_ref.ref()), static_cast<int32_t>(node_ref.ref()) + 1));
+            }
+        }
+    }
+
+    REQUIRE(20 == num_buffers);
+    REQUIRE(100 == last_way_id);
+}
+
+SECTION("nodes after ways") {
+    BufferSource source;
+    for (int b = 0; b < 4; ++b) {
+        auto& buffer = source.add_buffer();
+        for (int n = 1; n <= 100; ++n) {
+            add_node(buffer, b * 100 + n);
+        }
+    }
+    for (int b = 0; b < 4; ++b) {
+        add_way(source.add_buffer(), b + 1, {b * 100 + 1, b * 100 + 2});
+    }
+    for (int b = 4; b < 8; ++b) {
+        auto& buffer = source.add_buffer();
+        for (int n = 1; n <= 100; ++n) {
+            add_node(buffer, b * 100 + n);
+        }
+    }
+    {
+        auto& buffer = source.add_buffer();
+        add_node(buffer, 1000);
+        add_way(buffer, 5, {401, 799, 1000});
+    }
+    add_way(source.add_buffer(), 6, {1, 800, 1000});
+
+    index_type index;
+    handler_type handler(index);
+    osmium::handler::NodeLocationsForWaysStage<BufferSource, handler_type> stage(source, handler, 4);
+
+    int num_ways = 0;
+    while (osmium::memory::Buffer buffer = stage.read()) {
+        for (auto it = buffer.begin<osmium::Way>(); it != buffer.end<osmium::Way>(); ++it) {
+            ++num_ways;
+            for (const auto& node_ref : it->nodes()) {
+                REQUIRE(node_ref.location() == osmium::Location(static_cast<int32_t>(node_ref.ref()), static_cast<int32_t>(node_ref.ref()) + 1));
+            }
+        }
+    }
+
+    REQUIRE(6 == num_ways);
+}
+
+SECTION("missing node") {
+    BufferSource source;
+    add_node(source.add_buffer(), 1);
+    add_way(source.add_buffer(), 1, {1, 2});
+
+    index_type index;
+    handler_type handler(index);
+    osmium::handler::NodeLocationsForWaysStage<BufferSource, handler_type> stage(source, handler);
+
+    REQUIRE(stage.read());
+    REQUIRE_THROWS_AS(stage.read(), osmium::not_found);
+}
+
+}
+
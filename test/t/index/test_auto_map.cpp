@@ -0,0 +1,104 @@
+#include "catch.hpp"
+
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <osmium/index/map/auto.hpp>
+
+typedef osmium::index::map::map_type map_type;
+
+TEST_CASE("AutoMap") {
+
+    const size_t gb = 1024UL * 1024 * 1024;
+
+    SECTION("nothing_known") {
+        osmium::index::map::InputStatistics stats;
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 16 * gb) == map_type::sparse_table);
+    }
+
+    SECTION("planet_box") {
+        osmium::index::map::InputStatistics stats;
+        stats.box(osmium::Box(-180.0, -90.0, 180.0, 90.0));
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 256 * gb) == map_type::dense_mem);
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 64 * gb) == map_type::dense_file);
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 16 * gb) == map_type::dense_file);
+    }
+
+    SECTION("planet_box_with_max_id") {
+        osmium::index::map::InputStatistics stats;
+        stats.box(osmium::Box(-180.0, -90.0, 180.0, 90.0)).max_id(1000000);
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 16 * gb) == map_type::dense_mem);
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 1024 * 1024) == map_type::dense_file);
+    }
+
+    SECTION("small_extract") {
+        osmium::index::map::InputStatistics stats;
+        stats.box(osmium::Box(13.0, 52.0, 14.0, 53.0)).num_ids(1000000).max_id(3000000000);
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 16 * gb) == map_type::sparse_table);
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 512 * 1024 * 1024) == map_type::sparse_file);
+    }
+
+    SECTION("dense_input") {
+        osmium::index::map::InputStatistics stats;
+        for (osmium::unsigned_object_id_type id = 1; id <= 1000; ++id) {
+            stats.add(id);
+        }
+        REQUIRE(stats.num_ids() == 1000);
+        REQUIRE(stats.max_id() == 1000);
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 16 * gb) == map_type::dense_mem);
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 1000) == map_type::dense_file);
+
+        auto map = osmium::index::map::create_map<osmium::unsigned_object_id_type, osmium::Location>(stats, 16 * gb);
+        map->set(17, osmium::Location(1.0, 2.0));
+        REQUIRE(map->get(17) == osmium::Location(1.0, 2.0));
+    }
+
+    SECTION("density_threshold") {
+        osmium::index::map::InputStatistics stats;
+        stats.num_ids(300).max_id(999);
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 16 * gb) == map_type::sparse_table);
+        REQUIRE(osmium::index::map::choose_map_type<osmium::Location>(stats, 16 * gb, 0.25) == map_type::dense_mem);
+
+        auto map = osmium::index::map::create_map<osmium::unsigned_object_id_type, osmium::Location>(stats, 16 * gb, 0.25);
+        typedef osmium::index::map::SparseTable<osmium::unsigned_object_id_type, osmium::Location> sparse_type;
+        REQUIRE(dynamic_cast<sparse_type*>(map.get()) == nullptr);
+        map->set(999, osmium::Location(1.0, 2.0));
+        REQUIRE(map->get(999) == osmium::Location(1.0, 2.0));
+    }
+
+    SECTION("adaptive_map") {
+        osmium::index::map::AdaptiveMap<osmium::unsigned_object_id_type, osmium::Location> map(0.5, 1000);
+
+        map.set(1000000, osmium::Location(1.0, 1.0));
+        REQUIRE(!map.is_dense());
+
+        for (osmium::unsigned_object_id_type id = 1; id < 200000; ++id) {
+            map.set(id, osmium::Location(1.0, 2.0));
+        }
+        REQUIRE(!map.is_dense());
+        REQUIRE(map.get(1000000) == osmium::Location(1.0, 1.0));
+
+        for (osmium::unsigned_object_id_type id = 200000; id < 700000; ++id) {
+            map.set(id, osmium::Location(2.0, 2.0));
+        }
+        REQUIRE(map.is_dense());
+        REQUIRE(map.get(1) == osmium::Location(1.0, 2.0));
+        REQUIRE(map.get(600000) == osmium::Location(2.0, 2.0));
+        REQUIRE(map.get(1000000) == osmium::Location(1.0, 1.0));
+        REQUIRE_THROWS_AS(map.get(800000), osmium::not_found);
+
+        map.clear();
+        REQUIRE(!map.is_dense());
+        REQUIRE(0 == map.size());
+        REQUIRE_THROWS_AS(map.get(1), osmium::not_found);
+
+        // after clear() the density is checked against the new ids only
+        map.set(100000000, osmium::Location(3.0, 3.0));
+        for (osmium::unsigned_object_id_type id = 1; id < 200000; ++id) {
+            map.set(id, osmium::Location(1.0, 2.0));
+        }
+        REQUIRE(!map.is_dense());
+        REQUIRE(map.get(100000000) == osmium::Location(3.0, 3.0));
+    }
+
+}
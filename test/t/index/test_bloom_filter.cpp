@@ -0,0 +1,91 @@
+#include "catch.hpp"
+
+#include <utility>
+
+#include <osmium/index/bloom_filter.hpp>
+
+TEST_CASE("BloomFilter") {
+
+    SECTION("empty") {
+        osmium::index::BloomFilter<> filter;
+        REQUIRE(!filter.maybe_contains(0));
+        REQUIRE(!filter.maybe_contains(17));
+        REQUIRE(filter.used_memory() == 0);
+    }
+
+    SECTION("no_false_negatives") {
+        osmium::index::BloomFilter<> filter(10000);
+        for (osmium::unsigned_object_id_type id = 1; id < 1000000; id += 100) {
+            filter.insert(id);
+        }
+        for (osmium::unsigned_object_id_type id = 1; id < 1000000; id += 100) {
+            REQUIRE(filter.maybe_contains(id));
+        }
+        REQUIRE(filter.used_memory() >= 10000 * 10 / 8);
+    }
+
+    SECTION("few_false_positives") {
+        osmium::index::BloomFilter<> filter(100000);
+        for (osmium::unsigned_object_id_type id = 0; id < 100000; ++id) {
+            filter.insert(id * 2);
+        }
+        int false_positives = 0;
+        for (osmium::unsigned_object_id_type id = 0; id < 100000; ++id) {
+            if (filter.maybe_contains(id * 2 + 1)) {
+                ++false_positives;
+            }
+        }
+        REQUIRE(false_positives < 2000);
+    }
+
+    SECTION("reset") {
+        osmium::index::BloomFilter<> filter(100);
+        filter.insert(42);
+        REQUIRE(filter.maybe_contains(42));
+        filter.reset(100);
+        REQUIRE(!filter.maybe_contains(42));
+        filter.clear();
+        REQUIRE(!filter.maybe_contains(42));
+    }
+
+    SECTION("insert_into_empty_filter") {
+        osmium::index::BloomFilter<> filter;
+        REQUIRE(filter.used_memory() == 0);
+        REQUIRE(!filter.maybe_contains(42));
+        filter.insert(42);
+        REQUIRE(filter.maybe_contains(42));
+
+        filter.clear();
+        REQUIRE(!filter.maybe_contains(42));
+        filter.insert(43);
+        REQUIRE(filter.maybe_contains(43));
+
+        filter.reset(0);
+        filter.insert(44);
+        REQUIRE(filter.maybe_contains(44));
+
+        osmium::index::BloomFilter<> moved(std::move(filter));
+        filter.insert(45);
+        REQUIRE(filter.maybe_contains(45));
+    }
+
+    SECTION("move") {
+        osmium::index::BloomFilter<> filter(100);
+        filter.insert(42);
+
+        osmium::index::BloomFilter<> moved(std::move(filter));
+        REQUIRE(moved.maybe_contains(42));
+        REQUIRE(!filter.maybe_contains(42));
+        REQUIRE(filter.used_memory() == 0);
+
+        filter = std::move(moved);
+        REQUIRE(filter.maybe_contains(42));
+        REQUIRE(!moved.maybe_contains(42));
+        REQUIRE(moved.used_memory() == 0);
+
+        moved.reset(100);
+        moved.insert(17);
+        REQUIRE(moved.maybe_contains(17));
+    }
+
+}
@@ -0,0 +1,103 @@
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <map>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include <osmium/osm/types.hpp>
+#include <osmium/index/multimap/csr.hpp>
+
+typedef osmium::index::multimap::CsrMultimap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type> csr_type;
+
+template <typename TIndex>
+std::vector<osmium::unsigned_object_id_type> values(const TIndex& index, osmium::unsigned_object_id_type id) {
+    std::vector<osmium::unsigned_object_id_type> result;
+    auto range = index.get_all(id);
+    for (auto it = range.first; it != range.second; ++it) {
+        REQUIRE(it->first == id);
+        result.push_back(it->second);
+    }
+    return result;
+}
+
+TEST_CASE("CsrMultimap") {
+
+    SECTION("empty") {
+        csr_type index;
+        index.sort();
+        REQUIRE(index.size() == 0);
+        REQUIRE(index.num_keys() == 0);
+        REQUIRE(values(index, 17).empty());
+    }
+
+    SECTION("small") {
+        csr_type index;
+        index.set(5, 300);
+        index.set(2, 10);
+        index.set(5, 1);
+        index.set(5, 300);
+        index.set(1000000000000, 1);
+        index.sort();
+
+        REQUIRE(index.size() == 5);
+        REQUIRE(index.num_keys() == 3);
+        REQUIRE(values(index, 2) == (std::vector<osmium::unsigned_object_id_type> {10}));
+        REQUIRE(values(index, 5) == (std::vector<osmium::unsigned_object_id_type> {1, 300, 300}));
+        REQUIRE(values(index, 1000000000000) == (std::vector<osmium::unsigned_object_id_type> {1}));
+        REQUIRE(values(index, 3).empty());
+        REQUIRE(values(index, 0).empty());
+
+        REQUIRE_THROWS_AS(index.set(1, 1), std::logic_error);
+    }
+
+    SECTION("large_and_dump") {
+        std::multimap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type> expected;
+        csr_type index;
+        std::srand(42);
+        for (int i = 0; i < 500000; ++i) {
+            const osmium::unsigned_object_id_type id = std::rand() % 100000;
+            const osmium::unsigned_object_id_type value = std::rand();
+            expected.emplace(id, value);
+            index.set(id, value);
+        }
+        index.sort();
+        REQUIRE(index.size() == expected.size());
+        REQUIRE(index.used_memory() < expected.size() * 8);
+
+        char filename[] = "/tmp/osmium_unit_test_XXXXXX";
+        const int fd = mkstemp(filename);
+        REQUIRE(fd > 0);
+        REQUIRE(0 == unlink(filename));
+        index.dump(fd);
+
+        csr_type loaded(fd);
+        REQUIRE(loaded.size() == expected.size());
+        REQUIRE(loaded.num_keys() == index.num_keys());
+
+        for (osmium::unsigned_object_id_type id = 0; id < 100010; id += 7) {
+            std::vector<osmium::unsigned_object_id_type> v;
+            auto r = expected.equal_range(id);
+            for (auto it = r.first; it != r.second; ++it) {
+                v.push_back(it->second);
+            }
+            std::sort(v.begin(), v.end());
+            REQUIRE(values(index, id) == v);
+            REQUIRE(values(loaded, id) == v);
+        }
+        close(fd);
+    }
+
+    SECTION("invalid_file") {
+        char filename[] = "/tmp/osmium_unit_test_XXXXXX";
+        const int fd = mkstemp(filename);
+        REQUIRE(fd > 0);
+        REQUIRE(0 == unlink(filename));
+        const char data[64] = "not an index";
+        REQUIRE(64 == write(fd, data, 64));
+        REQUIRE_THROWS_AS(csr_type index(fd), std::runtime_error);
+        close(fd);
+    }
+
+}
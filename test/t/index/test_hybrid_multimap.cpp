@@ -0,0 +1,86 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <osmium/osm/types.hpp>
+#include <osmium/index/multimap/hybrid.hpp>
+
+typedef osmium::index::multimap::Hybrid<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type> hybrid_type;
+
+static std::vector<osmium::unsigned_object_id_type> values(hybrid_type& index, osmium::unsigned_object_id_type id) {
+    std::vector<osmium::unsigned_object_id_type> result;
+    auto range = index.get_all(id);
+    for (auto it = range.first; it != range.second; ++it) {
+        REQUIRE(it->first == id);
+        result.push_back(it->second);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TEST_CASE("HybridMultimap") {
+
+    hybrid_type index(4);
+
+    SECTION("empty") {
+        REQUIRE(values(index, 1).empty());
+        REQUIRE(index.size() == 0);
+    }
+
+    SECTION("unsorted_set_and_set") {
+        index.unsorted_set(3, 30);
+        index.unsorted_set(1, 10);
+        index.unsorted_set(3, 31);
+        index.sort();
+
+        for (osmium::unsigned_object_id_type i = 1; i <= 20; ++i) {
+            index.set(i % 5, 100 + i);
+        }
+        REQUIRE(index.size() == 23);
+
+        REQUIRE(values(index, 0) == (std::vector<osmium::unsigned_object_id_type> {105, 110, 115, 120}));
+        REQUIRE(values(index, 1) == (std::vector<osmium::unsigned_object_id_type> {10, 101, 106, 111, 116}));
+        REQUIRE(values(index, 3) == (std::vector<osmium::unsigned_object_id_type> {30, 31, 103, 108, 113, 118}));
+        REQUIRE(values(index, 7).empty());
+
+        // runs are merged so there are only a few of them
+        REQUIRE(index.num_runs() <= 4);
+
+        index.remove(3, 30);
+        index.remove(3, 108);
+        index.remove(1, 116);
+        index.remove(1, 999);
+        REQUIRE(values(index, 3) == (std::vector<osmium::unsigned_object_id_type> {31, 103, 113, 118}));
+        REQUIRE(values(index, 1) == (std::vector<osmium::unsigned_object_id_type> {10, 101, 106, 111}));
+
+        index.set(3, 108);
+        REQUIRE(values(index, 3) == (std::vector<osmium::unsigned_object_id_type> {31, 103, 108, 113, 118}));
+
+        index.consolidate();
+        REQUIRE(index.num_runs() == 1);
+        REQUIRE(index.size() == 21);
+        REQUIRE(values(index, 3) == (std::vector<osmium::unsigned_object_id_type> {31, 103, 108, 113, 118}));
+        REQUIRE(values(index, 1) == (std::vector<osmium::unsigned_object_id_type> {10, 101, 106, 111}));
+    }
+
+    SECTION("many_updates") {
+        const osmium::unsigned_object_id_type num = 10000;
+        for (osmium::unsigned_object_id_type i = 0; i < num; ++i) {
+            index.set(i % 100, i);
+        }
+        REQUIRE(index.num_runs() < 20);
+        REQUIRE(values(index, 42).size() == num / 100);
+
+        for (osmium::unsigned_object_id_type i = 0; i < num; i += 2) {
+            index.remove(i % 100, i);
+        }
+        REQUIRE(values(index, 42).empty());
+        REQUIRE(values(index, 43).size() == num / 100);
+
+        index.consolidate();
+        REQUIRE(index.size() == num / 2);
+    }
+
+}
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include <osmium/index/id_set.hpp>
+
+typedef osmium::index::IdSet<osmium::unsigned_object_id_type> id_set_type;
+
+static std::vector<osmium::unsigned_object_id_type> to_vector(const id_set_type& set) {
+    std::vector<osmium::unsigned_object_id_type> ids;
+    set.for_each([&ids](osmium::unsigned_object_id_type id) {
+        ids.push_back(id);
+    });
+    return ids;
+}
+
+TEST_CASE("IdSet") {
+
+SECTION("empty") {
+    id_set_type set;
+    REQUIRE(set.empty());
+    REQUIRE(0 == set.size());
+    REQUIRE_FALSE(set.contains(0));
+    REQUIRE_FALSE(set.contains(17));
+}
+
+SECTION("insert and contains") {
+    id_set_type set;
+    set.insert(17);
+    set.insert(3);
+    set.insert(17);
+    set.insert(1ULL << 40);
+
+    REQUIRE(3 == set.size());
+    REQUIRE(set.contains(3));
+    REQUIRE(set.contains(17));
+    REQUIRE(set.contains(1ULL << 40));
+    REQUIRE_FALSE(set.contains(4));
+    REQUIRE_FALSE(set.contains((1ULL << 40) + 17));
+
+    const std::vector<osmium::unsigned_object_id_type> expected = {3, 17, 1ULL << 40};
+    REQUIRE(expected == to_vector(set));
+
+    set.clear();
+    REQUIRE(set.empty());
+    REQUIRE_FALSE(set.contains(3));
+}
+
+SECTION("dense chunk switches to bitmap") {
+    id_set_type set;
+    for (osmium::unsigned_object_id_type id = 0; id < 20000; id += 2) {
+        set.insert(id);
+    }
+    REQUIRE(10000 == set.size());
+    for (osmium::unsigned_object_id_type id = 0; id < 20000; ++id) {
+        REQUIRE(set.contains(id) == (id % 2 == 0));
+    }
+}
+
+SECTION("bulk insert") {
+    std::vector<osmium::unsigned_object_id_type> ids = {70000, 5, 100000, 5, 6, 65536, 10};
+    id_set_type set;
+    set.insert(8);
+    set.insert(ids.cbegin(), ids.cend());
+
+    const std::vector<osmium::unsigned_object_id_type> expected = {5, 6, 8, 10, 65536, 70000, 100000};
+    REQUIRE(expected == to_vector(set));
+}
+
+SECTION("optimize to runs") {
+    id_set_type set;
+    for (osmium::unsigned_object_id_type id = 1000; id < 60000; ++id) {
+        set.insert(id);
+    }
+    set.insert(62000);
+    const size_t memory_before = set.used_memory();
+    set.optimize();
+    REQUIRE(set.used_memory() < memory_before);
+
+    REQUIRE(59001 == set.size());
+    REQUIRE_FALSE(set.contains(999));
+    REQUIRE(set.contains(1000));
+    REQUIRE(set.contains(30000));
+    REQUIRE(set.contains(59999));
+    REQUIRE_FALSE(set.contains(60000));
+    REQUIRE(set.contains(62000));
+    REQUIRE_FALSE(set.contains(62001));
+
+    set.insert(60000);
+    REQUIRE(set.contains(60000));
+    REQUIRE(59002 == set.size());
+}
+
+SECTION("union") {
+    id_set_type a;
+    id_set_type b;
+    for (osmium::unsigned_object_id_type id = 0; id < 10000; ++id) {
+        a.insert(id * 3);
+        b.insert(id * 5);
+    }
+    b.insert(1ULL << 33);
+
+    a |= b;
+    for (osmium::unsigned_object_id_type id = 0; id < 50000; ++id) {
+        REQUIRE(a.contains(id) == ((id < 30000 && id % 3 == 0) || id % 5 == 0));
+    }
+    REQUIRE(a.contains(1ULL << 33));
+}
+
+SECTION("intersection") {
+    id_set_type a;
+    id_set_type b;
+    for (osmium::unsigned_object_id_type id = 0; id < 10000; ++id) {
+        a.insert(id * 3);
+        b.insert(id * 5);
+    }
+    a.insert(1ULL << 33);
+    b.optimize();
+
+    const id_set_type c = a & b;
+    REQUIRE(c.size() == 2000);
+    for (osmium::unsigned_object_id_type id = 0; id < 30000; ++id) {
+        REQUIRE(c.contains(id) == (id % 15 == 0));
+    }
+    REQUIRE_FALSE(c.contains(1ULL << 33));
+}
+
+}
+
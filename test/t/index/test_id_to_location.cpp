@@ -121,6 +121,34 @@ SECTION("SparseTable") {
     test_func_real<index_type>(index2);
 }
 
+SECTION("SparseTableDumpAndLoad") {
+    typedef osmium::index::map::SparseTable<osmium::unsigned_object_id_type, osmium::Location> index_type;
+
+    index_type index1;
+    index1.set(3, osmium::Location(3.5, -7.2));
+    index1.set(12, osmium::Location(1.2, 4.5));
+    index1.set(1000, osmium::Location(1.0, 2.0));
+    REQUIRE(3 == index1.size());
+
+    char filename[] = "/tmp/osmium_unit_test_XXXXXX";
+    const int fd = mkstemp(filename);
+    REQUIRE(fd > 0);
+    REQUIRE(0 == unlink(filename));
+
+    index1.dump_as_array(fd);
+    REQUIRE(0 == lseek(fd, 0, SEEK_SET));
+
+    index_type index2;
+    index2.load(fd);
+    REQUIRE(3 == index2.size());
+    REQUIRE(osmium::Location(3.5, -7.2) == index2.get(3));
+    REQUIRE(osmium::Location(1.2, 4.5) == index2.get(12));
+    REQUIRE(osmium::Location(1.0, 2.0) == index2.get(1000));
+    REQUIRE_THROWS_AS(index2.get(5), osmium::not_found);
+
+    close(fd);
+}
+
 SECTION("StlMap") {
     typedef osmium::index::map::StlMap<osmium::unsigned_object_id_type, osmium::Location> index_type;
 
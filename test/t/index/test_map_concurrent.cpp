@@ -0,0 +1,106 @@
+#include "catch.hpp"
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <osmium/index/map/mmap_vector_anon.hpp>
+#include <osmium/index/map/sparse_table.hpp>
+#include <osmium/index/map/stl_vector.hpp>
+
+typedef std::pair<osmium::unsigned_object_id_type, osmium::Location> id_location_type;
+
+template <typename TIndex>
+void test_set_concurrently(TIndex& index) {
+    const int num_threads = 4;
+    const osmium::unsigned_object_id_type num_ids = 100000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&index, t, num_threads, num_ids]() {
+            std::vector<id_location_type> batch;
+            for (osmium::unsigned_object_id_type id = t; id < num_ids; id += num_threads) {
+                batch.emplace_back(id, osmium::Location(static_cast<int32_t>(id), static_cast<int32_t>(id) * 2));
+                if (batch.size() == 1000) {
+                    index.set_concurrently(batch.cbegin(), batch.cend());
+                    batch.clear();
+                }
+            }
+            index.set_concurrently(batch.cbegin(), batch.cend());
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(num_ids == index.size());
+    for (osmium::unsigned_object_id_type id = 0; id < num_ids; ++id) {
+        REQUIRE(osmium::Location(static_cast<int32_t>(id), static_cast<int32_t>(id) * 2) == index.get(id));
+    }
+    REQUIRE_THROWS_AS(index.get(num_ids), osmium::not_found);
+}
+
+TEST_CASE("MapConcurrent") {
+
+SECTION("DenseMapMem") {
+    osmium::index::map::DenseMapMem<osmium::unsigned_object_id_type, osmium::Location> index;
+    test_set_concurrently(index);
+}
+
+#ifdef __linux__
+SECTION("DenseMapMmap") {
+    osmium::index::map::DenseMapMmap<osmium::unsigned_object_id_type, osmium::Location> index;
+    test_set_concurrently(index);
+}
+#else
+# pragma message "not running 'DenseMapMmap' test case on this machine"
+#endif
+
+SECTION("SparseTable") {
+    osmium::index::map::SparseTable<osmium::unsigned_object_id_type, osmium::Location> index;
+    test_set_concurrently(index);
+}
+
+SECTION("DenseMapMemReserved") {
+    osmium::index::map::DenseMapMem<osmium::unsigned_object_id_type, osmium::Location> index;
+    index.reserve(100000);
+    test_set_concurrently(index);
+}
+
+SECTION("SetAndClear") {
+    osmium::index::map::DenseMapMem<osmium::unsigned_object_id_type, osmium::Location> index;
+    std::vector<id_location_type> batch;
+    batch.emplace_back(10, osmium::Location(1, 2));
+    index.set_concurrently(batch.cbegin(), batch.cend());
+    REQUIRE(11 == index.size());
+
+    index.set(20, osmium::Location(3, 4));
+    batch.clear();
+    batch.emplace_back(15, osmium::Location(5, 6));
+    index.set_concurrently(batch.cbegin(), batch.cend());
+    REQUIRE(21 == index.size());
+    REQUIRE(osmium::Location(5, 6) == index.get(15));
+    REQUIRE(osmium::Location(3, 4) == index.get(20));
+
+    index.clear();
+    REQUIRE(0 == index.size());
+    batch.clear();
+    batch.emplace_back(5, osmium::Location(7, 8));
+    index.set_concurrently(batch.cbegin(), batch.cend());
+    REQUIRE(6 == index.size());
+    REQUIRE(osmium::Location(7, 8) == index.get(5));
+    REQUIRE_THROWS_AS(index.get(4), osmium::not_found);
+}
+
+SECTION("EmptyRange") {
+    osmium::index::map::DenseMapMem<osmium::unsigned_object_id_type, osmium::Location> index;
+    std::vector<id_location_type> batch;
+    index.set_concurrently(batch.cbegin(), batch.cend());
+    REQUIRE(0 == index.size());
+}
+
+}
+
@@ -0,0 +1,56 @@
+#include "catch.hpp"
+
+#include <cstdint>
+
+#include <osmium/index/detail/mmap_vector_anon.hpp>
+#include <osmium/index/detail/mmap_vector_file.hpp>
+
+template <typename TVector>
+void test_mmap_vector_growth(TVector& vector) {
+    REQUIRE(vector.capacity() == osmium::detail::mmap_vector_size_increment);
+
+    const size_t num = 3 * osmium::detail::mmap_vector_size_increment + 17;
+    for (size_t i = 0; i < num; ++i) {
+        vector.push_back(i);
+    }
+
+    REQUIRE(vector.size() == num);
+    REQUIRE(vector.capacity() == 4 * osmium::detail::mmap_vector_size_increment);
+    REQUIRE(vector.advice() == osmium::detail::mmap_advice::random);
+    for (size_t i = 0; i < num; i += 1000) {
+        REQUIRE(vector[i] == i);
+    }
+    REQUIRE(vector.at(num - 1) == num - 1);
+
+    vector.reserve(5 * osmium::detail::mmap_vector_size_increment + 3);
+    REQUIRE(vector.capacity() == 5 * osmium::detail::mmap_vector_size_increment + 3);
+    REQUIRE(vector[num - 1] == num - 1);
+}
+
+TEST_CASE("MmapVector") {
+
+    SECTION("grow_capacity") {
+        const size_t inc = osmium::detail::mmap_vector_size_increment;
+        const size_t max = osmium::detail::mmap_vector_max_size_increment;
+        REQUIRE(osmium::detail::mmap_vector_grow_capacity(0, 1) == inc);
+        REQUIRE(osmium::detail::mmap_vector_grow_capacity(inc, inc + 1) == 2 * inc);
+        REQUIRE(osmium::detail::mmap_vector_grow_capacity(4 * inc, 4 * inc + 1) == 8 * inc);
+        REQUIRE(osmium::detail::mmap_vector_grow_capacity(4 * inc, 20 * inc) == 20 * inc);
+        REQUIRE(osmium::detail::mmap_vector_grow_capacity(2 * max, 2 * max + 1) == 3 * max);
+    }
+
+#ifdef __linux__
+    SECTION("anon") {
+        osmium::detail::mmap_vector_anon<uint64_t> vector;
+        vector.advise(osmium::detail::mmap_advice::random);
+        test_mmap_vector_growth(vector);
+    }
+#endif
+
+    SECTION("file") {
+        osmium::detail::mmap_vector_file<uint64_t> vector;
+        vector.advise(osmium::detail::mmap_advice::random);
+        test_mmap_vector_growth(vector);
+    }
+
+}
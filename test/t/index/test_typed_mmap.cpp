@@ -28,6 +28,22 @@ SECTION("MmapHugeSize") {
     REQUIRE_THROWS_AS(osmium::detail::typed_mmap<uint64_t>::map(1L << 50), std::system_error);
 }
 
+SECTION("MmapPopulateAndAdvise") {
+    uint64_t* data = osmium::detail::typed_mmap<uint64_t>::map(1000, true);
+
+    REQUIRE(osmium::detail::typed_mmap<uint64_t>::advise(data, 1000, osmium::detail::mmap_advice::random));
+    REQUIRE(osmium::detail::typed_mmap<uint64_t>::advise(data, 1000, osmium::detail::mmap_advice::sequential));
+    osmium::detail::typed_mmap<uint64_t>::advise(data, 1000, osmium::detail::mmap_advice::huge_pages);
+
+    data[0] = 4;
+    data[999] = 9;
+
+    REQUIRE(4 == data[0]);
+    REQUIRE(9 == data[999]);
+
+    osmium::detail::typed_mmap<uint64_t>::unmap(data, 1000);
+}
+
 #ifdef __linux__
 SECTION("Remap") {
     uint64_t* data = osmium::detail::typed_mmap<uint64_t>::map(10);
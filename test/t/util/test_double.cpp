@@ -0,0 +1,59 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+#include <osmium/util/double.hpp>
+
+static std::string to_string(double value) {
+    std::string s;
+    osmium::util::double2string(s, value);
+    return s;
+}
+
+TEST_CASE("double2string") {
+
+SECTION("shortest") {
+    REQUIRE(std::string{"0"} == to_string(0.0));
+    REQUIRE(std::string{"-0"} == to_string(-0.0));
+    REQUIRE(std::string{"0.1"} == to_string(0.1));
+    REQUIRE(std::string{"0.30000000000000004"} == to_string(0.1 + 0.2));
+    REQUIRE(std::string{"-1.5"} == to_string(-1.5));
+    REQUIRE(std::string{"123456"} == to_string(123456.0));
+    REQUIRE(std::string{"356222.37053847546"} == to_string(356222.37053847546));
+    REQUIRE(std::string{"9007199254740992"} == to_string(9007199254740992.0));
+}
+
+SECTION("notation") {
+    REQUIRE(std::string{"0.0001"} == to_string(0.0001));
+    REQUIRE(std::string{"1e-05"} == to_string(0.00001));
+    REQUIRE(std::string{"1e+15"} == to_string(1e15));
+    REQUIRE(std::string{"100000000000000"} == to_string(1e14));
+    REQUIRE(std::string{"1e+20"} == to_string(1e20));
+    REQUIRE(std::string{"1.2345e+100"} == to_string(1.2345e100));
+    REQUIRE(std::string{"1.7976931348623157e+308"} == to_string(std::numeric_limits<double>::max()));
+    REQUIRE(std::string{"5e-324"} == to_string(std::numeric_limits<double>::denorm_min()));
+}
+
+SECTION("not_finite") {
+    REQUIRE(std::string{"inf"} == to_string(std::numeric_limits<double>::infinity()));
+    REQUIRE(std::string{"-inf"} == to_string(-std::numeric_limits<double>::infinity()));
+}
+
+SECTION("round_trip") {
+    std::mt19937_64 rng(42);
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t bits = rng();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (value == value && value - value == 0) { // finite
+            REQUIRE(std::strtod(to_string(value).c_str(), nullptr) == value);
+        }
+    }
+}
+
+}